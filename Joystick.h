@@ -51,6 +51,16 @@
 #include <LUFA/Platform/Platform.h>
 
 #include "Descriptors.h"
+#include "profile.h"
+
+#ifdef PROFILE
+// Counts the programs' USB_USBTask() calls without touching each main loop.
+#define USB_USBTask() do { \
+		PROFILE_BEGIN(PROFILE_USB_TASK); \
+		(USB_USBTask)(); \
+		PROFILE_END(PROFILE_USB_TASK); \
+	} while (0)
+#endif
 
 // Type Defines
 // Enumeration for joystick buttons.
@@ -115,6 +125,7 @@ void HID_Task(void);
 // USB device event handlers.
 void EVENT_USB_Device_Connect(void);
 void EVENT_USB_Device_Disconnect(void);
+void EVENT_USB_Device_Reset(void);
 void EVENT_USB_Device_ConfigurationChanged(void);
 void EVENT_USB_Device_ControlRequest(void);
 // Prepare the next report for the host.
@@ -1,155 +1,109 @@
 #include <stdlib.h>
 #include "action.h"
 #include "Joystick.h"
+#include "idle.h"
+#include "profile.h"
+#include "telemetry.h"
+#include "timer.h"
 
-void setButton(USB_JoystickReport_Input_t *const ReportData, ACTION_t action) {
-    switch (action) {
-        case BUTTON_RESET:
-            ReportData->Button = 0;
-            ReportData->LX = STICK_CENTER;
-            ReportData->LY = STICK_CENTER;
-            ReportData->RX = STICK_CENTER;
-            ReportData->RY = STICK_CENTER;
-            ReportData->HAT = HAT_CENTER;
-            ReportData->VendorSpec = 0;
-            break;
-        case PAD_TOP:
-            ReportData->HAT = HAT_TOP;
-            break;
-        case PAD_TOP_LEFT:
-            ReportData->HAT = HAT_TOP_LEFT;
-            break;
-        case PAD_TOP_RIGHT:
-            ReportData->HAT = HAT_TOP_RIGHT;
-            break;
-        case PAD_BOTTOM:
-            ReportData->HAT = HAT_BOTTOM;
-            break;
-        case PAD_BOTTOM_LEFT:
-            ReportData->HAT = HAT_BOTTOM_LEFT;
-            break;
-        case PAD_BOTTOM_RIGHT:
-            ReportData->HAT = HAT_BOTTOM_RIGHT;
-            break;
-        case PAD_LEFT:
-            ReportData->HAT = HAT_LEFT;
-            break;
-        case PAD_RIGHT:
-            ReportData->HAT = HAT_RIGHT;
-            break;
-        case BUTTON_A:
-            ReportData->Button |= SWITCH_A;
-            break;
-        case BUTTON_B:
-            ReportData->Button |= SWITCH_B;
-            break;
-        case BUTTON_X:
-            ReportData->Button |= SWITCH_X;
-            break;
-        case BUTTON_Y:
-            ReportData->Button |= SWITCH_Y;
-            break;
-        case BUTTON_L:
-            ReportData->Button |= SWITCH_L;
-            break;
-        case BUTTON_R:
-            ReportData->Button |= SWITCH_R;
-            break;
-        case BUTTON_ZL:
-            ReportData->Button |= SWITCH_ZL;
-            break;
-        case BUTTON_ZR:
-            ReportData->Button |= SWITCH_ZR;
-            break;
-        case BUTTON_PLUS:
-            ReportData->Button |= SWITCH_PLUS;
-            break;
-        case BUTTON_MINUS:
-            ReportData->Button |= SWITCH_MINUS;
-            break;
-        case BUTTON_HOME:
-            ReportData->Button |= SWITCH_HOME;
-            break;
-        case BUTTON_CAPTURE:
-            ReportData->Button |= SWITCH_CAPTURE;
-            break;
-        case BUTTON_L_STICK:
-            ReportData->Button |= SWITCH_LCLICK;
-            break;
-        case BUTTON_R_STICK:
-            ReportData->Button |= SWITCH_RCLICK;
-            break;
-        case L_STICK_TOP:
-            ReportData->LX = STICK_CENTER;
-            ReportData->LY = STICK_MIN;
-            break;
-        case L_STICK_TOP_LEFT:
-            ReportData->LX = STICK_MIN;
-            ReportData->LY = STICK_MIN;
-            break;
-        case L_STICK_TOP_RIGHT:
-            ReportData->LX = STICK_MAX;
-            ReportData->LY = STICK_MIN;
-            break;
-        case L_STICK_BOTTOM:
-            ReportData->LX = STICK_CENTER;
-            ReportData->LY = STICK_MAX;
-            break;
-        case L_STICK_BOTTOM_LEFT:
-            ReportData->LX = STICK_MIN;
-            ReportData->LY = STICK_MAX;
-            break;
-        case L_STICK_BOTTOM_RIGHT:
-            ReportData->LX = STICK_MAX;
-            ReportData->LY = STICK_MAX;
-            break;
-        case L_STICK_LEFT:
-            ReportData->LX = STICK_MIN;
-            ReportData->LY = STICK_CENTER;
-            break;
-        case L_STICK_RIGHT:
-            ReportData->LX = STICK_MAX;
-            ReportData->LY = STICK_CENTER;
-            break;
-        case R_STICK_TOP:
-            ReportData->RX = STICK_CENTER;
-            ReportData->RY = STICK_MIN;
-            break;
-        case R_STICK_TOP_LEFT:
-            ReportData->RX = STICK_MIN;
-            ReportData->RY = STICK_MIN;
-            break;
-        case R_STICK_TOP_RIGHT:
-            ReportData->RX = STICK_MAX;
-            ReportData->RY = STICK_MIN;
-            break;
-        case R_STICK_BOTTOM:
-            ReportData->RX = STICK_CENTER;
-            ReportData->RY = STICK_MAX;
-            break;
-        case R_STICK_BOTTOM_LEFT:
-            ReportData->RX = STICK_MIN;
-            ReportData->RY = STICK_MAX;
-            break;
-        case R_STICK_BOTTOM_RIGHT:
-            ReportData->RX = STICK_MAX;
-            ReportData->RY = STICK_MAX;
-            break;
-        case R_STICK_LEFT:
-            ReportData->RX = STICK_MIN;
-            ReportData->RY = STICK_CENTER;
-            break;
-        case R_STICK_RIGHT:
-            ReportData->RX = STICK_MAX;
-            ReportData->RY = STICK_CENTER;
-            break;
+#define BUTTON(b)     {(b), 0, 0, 0, 0, 0, 0}
+#define PAD(h)        {0, (h), 0, 0, 0, 0, ACTION_FIELD_HAT}
+#define L_STICK(x, y) {0, 0, (x), (y), 0, 0, ACTION_FIELD_L_STICK}
+#define R_STICK(x, y) {0, 0, 0, 0, (x), (y), ACTION_FIELD_R_STICK}
+
+// Indexed by ACTION_t. Holes in the enum (0x20) are left zeroed and do nothing.
+static const ACTION_ENTRY_t actionTable[ACTION_COUNT] PROGMEM = {
+    [BUTTON_RESET]         = {0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER,
+                              ACTION_FIELD_CLEAR | ACTION_FIELD_HAT | ACTION_FIELD_L_STICK | ACTION_FIELD_R_STICK},
+    [PAD_TOP]              = PAD(HAT_TOP),
+    [PAD_TOP_LEFT]         = PAD(HAT_TOP_LEFT),
+    [PAD_TOP_RIGHT]        = PAD(HAT_TOP_RIGHT),
+    [PAD_BOTTOM]           = PAD(HAT_BOTTOM),
+    [PAD_BOTTOM_LEFT]      = PAD(HAT_BOTTOM_LEFT),
+    [PAD_BOTTOM_RIGHT]     = PAD(HAT_BOTTOM_RIGHT),
+    [PAD_LEFT]             = PAD(HAT_LEFT),
+    [PAD_RIGHT]            = PAD(HAT_RIGHT),
+    [BUTTON_A]             = BUTTON(SWITCH_A),
+    [BUTTON_B]             = BUTTON(SWITCH_B),
+    [BUTTON_X]             = BUTTON(SWITCH_X),
+    [BUTTON_Y]             = BUTTON(SWITCH_Y),
+    [BUTTON_L]             = BUTTON(SWITCH_L),
+    [BUTTON_R]             = BUTTON(SWITCH_R),
+    [BUTTON_ZL]            = BUTTON(SWITCH_ZL),
+    [BUTTON_ZR]            = BUTTON(SWITCH_ZR),
+    [BUTTON_PLUS]          = BUTTON(SWITCH_PLUS),
+    [BUTTON_MINUS]         = BUTTON(SWITCH_MINUS),
+    [BUTTON_HOME]          = BUTTON(SWITCH_HOME),
+    [BUTTON_CAPTURE]       = BUTTON(SWITCH_CAPTURE),
+    [BUTTON_L_STICK]       = BUTTON(SWITCH_LCLICK),
+    [BUTTON_R_STICK]       = BUTTON(SWITCH_RCLICK),
+    [L_STICK_TOP]          = L_STICK(STICK_CENTER, STICK_MIN),
+    [L_STICK_TOP_LEFT]     = L_STICK(STICK_MIN, STICK_MIN),
+    [L_STICK_TOP_RIGHT]    = L_STICK(STICK_MAX, STICK_MIN),
+    [L_STICK_BOTTOM]       = L_STICK(STICK_CENTER, STICK_MAX),
+    [L_STICK_BOTTOM_LEFT]  = L_STICK(STICK_MIN, STICK_MAX),
+    [L_STICK_BOTTOM_RIGHT] = L_STICK(STICK_MAX, STICK_MAX),
+    [L_STICK_LEFT]         = L_STICK(STICK_MIN, STICK_CENTER),
+    [L_STICK_RIGHT]        = L_STICK(STICK_MAX, STICK_CENTER),
+    [R_STICK_TOP]          = R_STICK(STICK_CENTER, STICK_MIN),
+    [R_STICK_TOP_LEFT]     = R_STICK(STICK_MIN, STICK_MIN),
+    [R_STICK_TOP_RIGHT]    = R_STICK(STICK_MAX, STICK_MIN),
+    [R_STICK_BOTTOM]       = R_STICK(STICK_CENTER, STICK_MAX),
+    [R_STICK_BOTTOM_LEFT]  = R_STICK(STICK_MIN, STICK_MAX),
+    [R_STICK_BOTTOM_RIGHT] = R_STICK(STICK_MAX, STICK_MAX),
+    [R_STICK_LEFT]         = R_STICK(STICK_MIN, STICK_CENTER),
+    [R_STICK_RIGHT]        = R_STICK(STICK_MAX, STICK_CENTER),
+};
+
+static void applyEntry(USB_JoystickReport_Input_t *const ReportData, const ACTION_ENTRY_t *entry) {
+    if (entry->fields & ACTION_FIELD_CLEAR) {
+        ReportData->Button = 0;
+        ReportData->VendorSpec = 0;
+    }
+    ReportData->Button |= entry->button;
+    if (entry->fields & ACTION_FIELD_HAT)
+        ReportData->HAT = entry->hat;
+    if (entry->fields & ACTION_FIELD_L_STICK) {
+        ReportData->LX = entry->lx;
+        ReportData->LY = entry->ly;
+    }
+    if (entry->fields & ACTION_FIELD_R_STICK) {
+        ReportData->RX = entry->rx;
+        ReportData->RY = entry->ry;
     }
 }
 
+void setButton(USB_JoystickReport_Input_t *const ReportData, ACTION_t action) {
+    ACTION_ENTRY_t entry;
+
+    if ((uint8_t) action >= ACTION_COUNT)
+        return;
+    PROFILE_BEGIN(PROFILE_SET_BUTTON);
+    memcpy_P(&entry, &actionTable[action], sizeof(entry));
+    applyEntry(ReportData, &entry);
+    PROFILE_END(PROFILE_SET_BUTTON);
+}
+
+void setButtons(USB_JoystickReport_Input_t *const ReportData, const ACTION_t *actions, uint8_t count) {
+    while (count--)
+        setButton(ReportData, *actions++);
+}
+
+void setInput(USB_JoystickReport_Input_t *const ReportData, const INPUT_MAP_t *input) {
+    ReportData->Button = input->button;
+    ReportData->HAT = input->hat;
+    ReportData->LX = input->lx;
+    ReportData->LY = input->ly;
+    ReportData->RX = input->rx;
+    ReportData->RY = input->ry;
+    ReportData->VendorSpec = 0;
+}
+
+// Sleeps between timer ticks instead of burning cycles; needs Timer_Init().
 void delay(double ms) {
-    ms = abs(ms);
-    while (ms > 0) {
-        _delay_ms(1);
-        ms--;
-    }
+    uint32_t deadline = millis() + (uint32_t) abs(ms);
+
+    while (!Timer_Reached(deadline))
+        Idle_Sleep();
+    TELEMETRY_ADD(late_ms, millis() - deadline);
 }
@@ -49,13 +49,61 @@ typedef enum {
   R_STICK_RIGHT = 0x27,
 } ACTION_t;
 
+#define ACTION_COUNT (R_STICK_RIGHT + 1)
+
+// Report fields an action table entry overwrites; buttons are always OR-ed in.
+#define ACTION_FIELD_CLEAR   0x01 // Button and VendorSpec are cleared first
+#define ACTION_FIELD_HAT     0x02
+#define ACTION_FIELD_L_STICK 0x04
+#define ACTION_FIELD_R_STICK 0x08
+
+// One entry of the flash-resident action table, indexed by ACTION_t.
+typedef struct {
+  uint16_t button;
+  uint8_t hat;
+  uint8_t lx;
+  uint8_t ly;
+  uint8_t rx;
+  uint8_t ry;
+  uint8_t fields;
+} ACTION_ENTRY_t;
+
 typedef struct {
   ACTION_t action;
   uint16_t wait_time;
 } BUTTON_MAP_t;
 
+// A step carrying the whole controller state at once: button mask, HAT and both sticks.
+// Use it where a single ACTION_t is not enough, e.g. holding a stick while pressing A.
+typedef struct {
+  uint16_t button; // see JoystickButtons_t
+  uint8_t hat;
+  uint8_t lx;
+  uint8_t ly;
+  uint8_t rx;
+  uint8_t ry;
+  uint16_t hold_time;
+  uint16_t wait_time;
+} INPUT_MAP_t;
+
+// Shorthands for INPUT_MAP_t tables.
+#define STICK_NEUTRAL STICK_CENTER, STICK_CENTER
+#define INPUT_BUTTON(button, hold, wait) \
+  {(button), HAT_CENTER, STICK_NEUTRAL, STICK_NEUTRAL, (hold), (wait)}
+#define INPUT_L_STICK(button, x, y, hold, wait) \
+  {(button), HAT_CENTER, (x), (y), STICK_NEUTRAL, (hold), (wait)}
+
 void setButton(USB_JoystickReport_Input_t *ReportData, ACTION_t action);
 
+void setButtons(USB_JoystickReport_Input_t *ReportData, const ACTION_t *actions, uint8_t count);
+
+// Apply several actions at once, e.g. setChord(ReportData, BUTTON_L, BUTTON_R).
+#define setChord(ReportData, ...) \
+  setButtons((ReportData), (const ACTION_t[]) {__VA_ARGS__}, \
+      sizeof((const ACTION_t[]) {__VA_ARGS__}) / sizeof(ACTION_t))
+
+void setInput(USB_JoystickReport_Input_t *ReportData, const INPUT_MAP_t *input);
+
 void delay(double ms);
 
 #endif
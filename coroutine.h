@@ -0,0 +1,107 @@
+#ifndef _COROUTINE_H_
+#define _COROUTINE_H_
+
+#include "action.h"
+#include "timer.h"
+
+// Stackless coroutines in the style of protothreads, for writing a program as
+// straight-line code instead of a mapPos/state/holding/waiting machine.
+//
+// The program body is a function returning bool, called once per report from
+// GetNextReport(). Every CO_* wait returns to HID_Task and resumes right after
+// the wait on the next poll, so USB is never blocked. Locals do not survive a
+// wait: keep loop counters static, or use `pos` for CO_PLAY.
+//
+//   static bool program(CO_t *co) {
+//     CO_BEGIN(co);
+//     CO_SYNC(co);
+//     for (;;) {
+//       CO_TAP(co, BUTTON_A, 50, 500);
+//       CO_PLAY(co, someMap);
+//     }
+//     CO_END(co);
+//   }
+//
+// Two CO_* waits must not share a `switch` label, which is why the resume
+// points are numbered with __COUNTER__ rather than __LINE__.
+typedef struct {
+  uint16_t resume;
+  uint8_t pos;
+  uint32_t wake;
+  USB_JoystickReport_Input_t report; // held until changed by CO_PRESS/CO_CHORD
+} CO_t;
+
+#define CO_DEFAULT_HOLD 50
+
+// Static initialiser: start from the top with a neutral report.
+#define CO_INITIALIZER \
+  {0, 0, 0, {0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, 0}}
+
+#define CO_BEGIN(co) switch ((co)->resume) { case 0:
+
+#define CO_END(co) } (co)->resume = 0; return false
+
+#define _CO_WAIT_AT(co, ms, n) \
+  do { \
+    (co)->wake = millis() + (ms); \
+    (co)->resume = (n); \
+    case (n): \
+    if (!Timer_Reached((co)->wake)) \
+      return true; \
+  } while (0)
+
+// Give the poll back and continue after at least `ms` milliseconds.
+#define CO_WAIT(co, ms) _CO_WAIT_AT(co, ms, __COUNTER__ + 1)
+
+#define _CO_YIELD_AT(co, n) \
+  do { \
+    (co)->resume = (n); \
+    return true; \
+    case (n):; \
+  } while (0)
+
+// Give the poll back and continue on the next one.
+#define CO_YIELD(co) _CO_YIELD_AT(co, __COUNTER__ + 1)
+
+// Hold `action` for `hold` ms, then release everything.
+#define CO_PRESS(co, action, hold) \
+  do { \
+    setButton(&(co)->report, (action)); \
+    CO_WAIT(co, hold); \
+    setButton(&(co)->report, BUTTON_RESET); \
+  } while (0)
+
+// Hold several actions at once for `hold` ms, then release everything.
+#define CO_CHORD(co, hold, ...) \
+  do { \
+    setChord(&(co)->report, __VA_ARGS__); \
+    CO_WAIT(co, hold); \
+    setButton(&(co)->report, BUTTON_RESET); \
+  } while (0)
+
+// Press, release and stay neutral for `wait` ms.
+#define CO_TAP(co, action, hold, wait) \
+  do { CO_PRESS(co, action, hold); CO_WAIT(co, wait); } while (0)
+
+// Play a BUTTON_MAP_t table with the default hold time.
+#define CO_PLAY(co, map) \
+  for ((co)->pos = 0; (co)->pos < sizeof(map) / sizeof(BUTTON_MAP_t); (co)->pos++) \
+    CO_TAP(co, (map)[(co)->pos].action, CO_DEFAULT_HOLD, (map)[(co)->pos].wait_time)
+
+// The L+R / A handshake every program starts with.
+#define CO_SYNC(co) \
+  do { \
+    CO_WAIT(co, 1000); \
+    CO_CHORD(co, CO_DEFAULT_HOLD, BUTTON_L, BUTTON_R); \
+    CO_WAIT(co, 1000); \
+    CO_CHORD(co, CO_DEFAULT_HOLD, BUTTON_L, BUTTON_R); \
+    CO_WAIT(co, 1000); \
+    CO_TAP(co, BUTTON_A, CO_DEFAULT_HOLD, 1000); \
+    CO_TAP(co, BUTTON_A, CO_DEFAULT_HOLD, 500); \
+  } while (0)
+
+// Copy the held report out; call after running the program body.
+#define CO_REPORT(co, ReportData) \
+  memcpy((ReportData), &(co)->report, sizeof(USB_JoystickReport_Input_t))
+
+#endif
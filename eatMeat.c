@@ -26,6 +26,14 @@ these buttons for our use.
 
 #include "Joystick.h"
 #include "action.h"
+#include "feedback.h"
+#include "grid.h"
+#include "idle.h"
+#include "params.h"
+#include "resync.h"
+#include "stats.h"
+#include "telemetry.h"
+#include "timer.h"
 //#include <Arduino/hardware/arduino/avr/cores/arduino/Arduino.h>
 #ifndef ALERT_WHEN_DONE
 #define ALERT_WHEN_DONE
@@ -43,6 +51,8 @@ int main(void) {
     HID_Task();
     // We also need to run the main USB management task.
     USB_USBTask();
+    // Then doze until the next timer tick or USB interrupt.
+    Idle_Sleep();
   }
 }
 
@@ -66,79 +76,18 @@ PORTD will toggle when printing is done.
   DDRB = 0xFF; //uses PORTB. Micro can use either or, but both give us 2 LEDs
   PORTB = 0x0; //The ATmega328P on the UNO will be resetting, so unplug it?
 #endif
+  // Timer1 paces delay() and the idle sleep in the main loop.
+  Timer_Init();
+  // Loading screens can end waits early, see feedback.h.
+  Feedback_Init();
+  // bladeNum/bladePos can be overridden from a PC, see params.h.
+  Params_Init(PARAMS_EAT_MEAT);
+  // Rounds per hour and time per state, see host/statsctl.
+  Stats_Init(PARAMS_EAT_MEAT);
   // The USB stack should be initialized last.
   USB_Init();
 }
 
-// Fired to indicate that the device is enumerating.
-void EVENT_USB_Device_Connect(void) {
-  // We can indicate that we're enumerating here (via status LEDs, sound, etc.).
-}
-
-// Fired to indicate that the device is no longer connected to a host.
-void EVENT_USB_Device_Disconnect(void) {
-  // We can indicate that our device is not ready (via status LEDs, sound, etc.).
-}
-
-// Fired when the host set the current configuration of the USB device after enumeration.
-void EVENT_USB_Device_ConfigurationChanged(void) {
-  bool ConfigSuccess = true;
-
-  // We setup the HID report endpoints.
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-
-  // We can read ConfigSuccess to indicate a success or failure at this point.
-}
-
-// Process control requests sent to the device from the USB host.
-void EVENT_USB_Device_ControlRequest(void) {
-  // We can handle two control requests: a GetReport and a SetReport.
-
-  // Not used here, it looks like we don't receive control request from the Switch.
-}
-
-// Process and deliver data from IN and OUT endpoints.
-void HID_Task(void) {
-  // If the device isn't connected and properly configured, we can't do anything here.
-  if (USB_DeviceState != DEVICE_STATE_Configured)
-    return;
-
-  // We'll start with the OUT endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
-  // We'll check to see if we received something on the OUT endpoint.
-  if (Endpoint_IsOUTReceived()) {
-    // If we did, and the packet has data, we'll react to it.
-    if (Endpoint_IsReadWriteAllowed()) {
-      // We'll create a place to store our data received from the host.
-      USB_JoystickReport_Output_t JoystickOutputData;
-      // We'll then take in that data, setting it up in our storage.
-      while (Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL) !=
-          ENDPOINT_RWSTREAM_NoError);
-      // At this point, we can react to this data.
-
-      // However, since we're not doing anything with this data, we abandon it.
-    }
-    // Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
-    Endpoint_ClearOUT();
-  }
-
-  // We'll then move on to the IN endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
-  // We first check to see if the host is ready to accept data.
-  if (Endpoint_IsINReady()) {
-    // We'll create an empty report.
-    USB_JoystickReport_Input_t JoystickInputData;
-    // We'll then populate this report with what we want to send to the host.
-    GetNextReport(&JoystickInputData);
-    // Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
-    while (Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL) !=
-        ENDPOINT_RWSTREAM_NoError);
-    // We then send an IN packet on this endpoint.
-    Endpoint_ClearIN();
-  }
-}
-
 typedef enum {
   SYNC_CONTROLLER,
   PREPARE,
@@ -150,6 +99,7 @@ typedef enum {
   EAT_PRE,
   EATING,
   CONFIRM_BLADE,
+  RESYNC,
   DONE
 } State_t;
 State_t state = SYNC_CONTROLLER;
@@ -222,37 +172,53 @@ BUTTON_MAP_t confirm[] = {
     {PAD_RIGHT,   500},
     {BUTTON_A,    1000},
     {PAD_RIGHT,   500},
-    {BUTTON_A,    10000},
+    {BUTTON_A,    UNTIL_READY(10000)},
     {BUTTON_A,    500},
-    {BUTTON_ZR,   10000},
+    {BUTTON_ZR,   UNTIL_READY(10000)},
     {BUTTON_A,    500},
-    {BUTTON_ZR,   10000},
+    {BUTTON_ZR,   UNTIL_READY(10000)},
     {BUTTON_A,    500},
     {BUTTON_PLUS, 1500},
 };
 
+// 每 5 轮多按几次 B 确保回到地图上，再从 prepare 开始
+BUTTON_MAP_t escape[] = {
+    {BUTTON_B, 1000},
+    {BUTTON_B, 1000},
+    {BUTTON_B, 1000},
+    {BUTTON_B, 1000},
+    {BUTTON_B, 1000},
+    {BUTTON_B, 2000},
+};
+
 // endregion
 
+RESYNC_t resync = RESYNC(escape, 5);
+
 int report_count = 0;
 int mapPos = 0;
 
-int bladeNum = 26;
+int bladeNum = 26; // 默认值，EEPROM 里设置过的话以那个为准
 int bladePos = 3;
-int line = 0;
-int row = 0;
+// 异刃列表，一行 5 个，打开时光标在第一个。游戏里上下能循环的话加上 GRID_WRAP_ROWS，刀多的时候省不少步
+GRID_t blades = GRID(5, 26, 0);
 
 bool holding = true;
 bool waiting = false;
 
 #define DEFAULT_HOLD_TIME 50
 int hold_time = DEFAULT_HOLD_TIME;
-int wait_time = 50;
+uint16_t wait_time = 50;
 
 uint8_t ports_val = 0;
 
 // Prepare the next report for the host.
 void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
+  ACTION_t action;
+  const BUTTON_MAP_t *step;
 
+  Stats_Track(state);
+  Telemetry_Mark(state, mapPos);
   setButton(ReportData, BUTTON_RESET);
 
   if (holding && hold_time) {
@@ -268,7 +234,7 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
     PORTD = ~ports_val;
     PORTB = ~ports_val;
     #endif
-    delay(wait_time);
+    Feedback_Wait(wait_time);
     waiting = false;
   } else {
     // region doing
@@ -278,6 +244,8 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
         report_count = 0;
         wait_time = 200;
         state = PREPARE;
+        bladePos = Params_Get(PARAM_BLADE_POS, bladePos);
+        blades.count = Params_Get(PARAM_BLADE_NUM, bladeNum);
       } else if (report_count == 25 || report_count == 50) {
         ReportData->Button |= SWITCH_L | SWITCH_R;
       } else if (report_count == 75 || report_count == 100) {
@@ -318,8 +286,6 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       break;
     case CHANGE_POS:
       bladePos++;
-      line = (bladePos - 1) / 5;
-      row = (bladePos - 1) % 5;
       state = CHANGE_PRE;
       if (bladePos % 3 == 1) { // 第一个
         //setButton(ReportData, PAD_BOTTOM);
@@ -335,16 +301,14 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
     case CHANGE_PRE:
       setButton(ReportData, BUTTON_A);
       wait_time = 500;
+      Grid_Reset(&blades, 0);
       state = CHANGING;
       break;
     case CHANGING:
       wait_time = 50;
-      if (line > 0) {
-        line--;
-        setButton(ReportData, PAD_BOTTOM);
-      } else if (row > 0) {
-        row--;
-        setButton(ReportData, PAD_RIGHT);
+      action = Grid_Step(&blades, bladePos - 1);
+      if (action != BUTTON_RESET) {
+        setButton(ReportData, action);
       } else {
         setButton(ReportData, BUTTON_A);
         wait_time = 500;
@@ -381,13 +345,23 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       mapPos++;
       if (mapPos >= (sizeof(confirm) / sizeof(BUTTON_MAP_t))) {
         mapPos = 0;
-        state = PREPARE;
-        if (bladePos >= bladeNum) {
+        state = Resync_Due(&resync) ? RESYNC : PREPARE;
+        if (bladePos >= Params_Get(PARAM_BLADE_NUM, bladeNum)) {
           state = DONE;
           break;
         }
       }
       break;
+    case RESYNC:
+      step = Resync_Next(&resync);
+      if (step) {
+        setButton(ReportData, step->action);
+        wait_time = step->wait_time;
+      } else {
+        state = PREPARE;
+        wait_time = 0;
+      }
+      break;
     case DONE:
       hold_time = 2000;
       wait_time = 2000;
@@ -0,0 +1,101 @@
+#include <stddef.h>
+#include <util/atomic.h>
+
+#include "eventlog.h"
+#include "timer.h"
+
+#ifdef EVENTLOG
+
+static EVENTLOG_REPORT_t eventlog = {
+    .report_id = EVENTLOG_REPORT_ID,
+    .size = EVENTLOG_SIZE,
+};
+
+// What EventLog_Mark() saw last.
+static uint8_t marked_state = 0xFF;
+static uint16_t marked_pos;
+
+static uint16_t since(uint32_t now, uint32_t dt) {
+    dt += now - eventlog.last_ms;
+    return dt < EVENTLOG_DT_MAX ? dt : EVENTLOG_DT_MAX;
+}
+
+static EVENTLOG_EVENT_t *newest(void) {
+    if (!eventlog.count)
+        return NULL;
+    return &eventlog.events[(eventlog.head + EVENTLOG_SIZE - 1) % EVENTLOG_SIZE];
+}
+
+static void append(uint8_t kind, uint8_t value) {
+    uint32_t now = millis();
+    EVENTLOG_EVENT_t *event = &eventlog.events[eventlog.head];
+
+    event->dt_ms = since(now, 0);
+    event->kind = kind;
+    event->value = value;
+    eventlog.head = (eventlog.head + 1) % EVENTLOG_SIZE;
+    if (eventlog.count < EVENTLOG_SIZE)
+        eventlog.count++;
+    eventlog.last_ms = now;
+}
+
+void EventLog_Add(uint8_t kind, uint8_t value) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        append(kind, value);
+    }
+}
+
+static void add_step(uint16_t step) {
+    if (step > EVENTLOG_STEP_MAX)
+        step = EVENTLOG_STEP_MAX;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        EVENTLOG_EVENT_t *event = newest();
+
+        if (event && event->kind == EVENTLOG_STEP) {
+            uint32_t now = millis();
+            event->dt_ms = since(now, event->dt_ms);
+            event->value = step;
+            eventlog.last_ms = now;
+        } else {
+            append(EVENTLOG_STEP, step);
+        }
+    }
+}
+
+void EventLog_Mark(uint8_t state, uint16_t map_pos) {
+    if (state != marked_state)
+        EventLog_Add(EVENTLOG_STATE, state);
+    else if (map_pos != marked_pos)
+        add_step(map_pos);
+    marked_state = state;
+    marked_pos = map_pos;
+}
+
+void EventLog_Count(uint8_t kind) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        EVENTLOG_EVENT_t *event = newest();
+
+        // The event keeps the time of the first one.
+        if (event && event->kind == kind) {
+            if (event->value < 0xFF)
+                event->value++;
+        } else {
+            append(kind, 1);
+        }
+    }
+}
+
+void EventLog_Clear(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        eventlog.head = 0;
+        eventlog.count = 0;
+        eventlog.last_ms = millis();
+    }
+}
+
+EVENTLOG_REPORT_t *EventLog_Report(void) {
+    eventlog.now_ms = millis();
+    return &eventlog;
+}
+
+#endif
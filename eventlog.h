@@ -0,0 +1,82 @@
+#ifndef _EVENTLOG_H_
+#define _EVENTLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The last EVENTLOG_SIZE things that happened, for finding out what an
+// overnight run was doing when it went wrong: state changes, the step the
+// program reached in each state, and USB and stream trouble. Kept in RAM,
+// so it survives everything but a reset; 4 bytes an event.
+//
+// Read it with Feature report EVENTLOG_REPORT_ID (host/eventdump), which
+// hid.c answers straight from the ring; a SetReport of just the report ID
+// clears it. Programs log through Telemetry_Mark().
+//
+// Build with EVENTLOG (make with-eventlog); otherwise the functions below
+// compile to nothing and the ring's RAM is left to the stack.
+#ifndef EVENTLOG_SIZE
+#define EVENTLOG_SIZE 16
+#endif
+#define EVENTLOG_REPORT_ID 4
+#define EVENTLOG_DT_MAX    0xFFFF // gap too long to tell
+#define EVENTLOG_STEP_MAX  0xFF   // step too far to tell, e.g. eatMeat's EATING
+
+typedef enum {
+  EVENTLOG_NONE,
+  EVENTLOG_STATE,            // value: the state entered
+  EVENTLOG_STEP,             // value: mapPos, EVENTLOG_STEP_MAX for that or more; only the latest of a run is kept
+  EVENTLOG_CONNECT,
+  EVENTLOG_DISCONNECT,
+  EVENTLOG_BUS_RESET,        // the host reset the bus, e.g. the Switch dropping the pad
+  EVENTLOG_CONFIG_FAILED,
+  EVENTLOG_UNDERRUN,         // value: how many in a row
+  EVENTLOG_STREAM_ERROR,     // value: how many in a row
+  EVENTLOG_FEEDBACK_TIMEOUT,
+  EVENTLOG_RESYNC,           // value: 1 if asked for rather than scheduled
+} EVENTLOG_KIND_t;
+
+typedef struct __attribute__((packed)) {
+  uint16_t dt_ms; // since the event before, up to EVENTLOG_DT_MAX
+  uint8_t kind;   // EVENTLOG_KIND_t
+  uint8_t value;
+} EVENTLOG_EVENT_t;
+
+// Feature report EVENTLOG_REPORT_ID as read by the host, and the ring itself.
+typedef struct __attribute__((packed)) {
+  uint8_t report_id;
+  uint8_t size;     // EVENTLOG_SIZE
+  uint8_t head;     // slot of the next event; the oldest one once the ring is full
+  uint8_t count;    // events in use
+  uint32_t last_ms; // millis() at the newest event
+  uint32_t now_ms;  // millis() when read
+  EVENTLOG_EVENT_t events[EVENTLOG_SIZE];
+} EVENTLOG_REPORT_t;
+
+#ifdef EVENTLOG
+
+// All of these may be called from interrupts.
+void EventLog_Add(uint8_t kind, uint8_t value);
+
+// Logs a change of the program's state, or else of its step within the
+// state. A step replaces the newest event if that is a step too, keeping the
+// ring for what happened between states. Steps past EVENTLOG_STEP_MAX are
+// logged as it.
+void EventLog_Mark(uint8_t state, uint16_t step);
+
+// Counts repeats of the newest event instead of adding them.
+void EventLog_Count(uint8_t kind);
+
+void EventLog_Clear(void);
+
+EVENTLOG_REPORT_t *EventLog_Report(void);
+
+#else
+
+static inline void EventLog_Add(uint8_t kind, uint8_t value) { (void) kind; (void) value; }
+static inline void EventLog_Mark(uint8_t state, uint16_t step) { (void) state; (void) step; }
+static inline void EventLog_Count(uint8_t kind) { (void) kind; }
+
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+#include "feedback.h"
+#include "Joystick.h"
+#include "action.h"
+#include "eventlog.h"
+#include "idle.h"
+#include "timer.h"
+
+FEEDBACK_STATS_t feedback_stats;
+
+#ifdef FEEDBACK_INPUT
+
+// The pin has gone busy at least once, so something drives it.
+static bool driven;
+
+static bool ready(void) {
+    return !!(FEEDBACK_PIN & (1 << FEEDBACK_BIT)) == FEEDBACK_READY_LEVEL;
+}
+
+void Feedback_Init(void) {
+    FEEDBACK_DDR &= ~(1 << FEEDBACK_BIT);
+    FEEDBACK_PORT |= 1 << FEEDBACK_BIT;
+}
+
+void Feedback_Wait(uint16_t wait_time) {
+    uint16_t ms = wait_time & ~FEEDBACK_UNTIL_READY;
+    uint32_t start = millis(), settled = 0;
+    bool busy = false, settling = false;
+
+    if (!(wait_time & FEEDBACK_UNTIL_READY)) {
+        delay(ms);
+        return;
+    }
+    // Sampled on every wakeup, i.e. at least once a millisecond.
+    while (!Timer_Reached(start + ms)) {
+        if (!ready()) {
+            busy = driven = true;
+            settling = false;
+        } else if (busy && !settling) {
+            settled = millis();
+            settling = true;
+        } else if (settling && Timer_Reached(settled + FEEDBACK_SETTLE_MS)) {
+            feedback_stats.early++;
+            feedback_stats.saved_ms += start + ms - millis();
+            return;
+        }
+        Idle_Sleep();
+    }
+    if (!driven) {
+        feedback_stats.never_busy++;
+        return;
+    }
+    feedback_stats.timeouts++;
+    EventLog_Add(EVENTLOG_FEEDBACK_TIMEOUT, 0);
+}
+
+#else
+
+void Feedback_Init(void) {
+}
+
+void Feedback_Wait(uint16_t wait_time) {
+    delay(wait_time & ~FEEDBACK_UNTIL_READY);
+}
+
+#endif
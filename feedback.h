@@ -0,0 +1,59 @@
+#ifndef _FEEDBACK_H_
+#define _FEEDBACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Optional "console is ready" input, so that loading screens are waited out
+// at the console's real speed instead of a worst-case fixed wait. Build with
+// FEEDBACK_INPUT (make with-feedback) and drive FEEDBACK_BIT from a
+// photodiode comparator or a PC-side screen detector: FEEDBACK_READY_LEVEL
+// while the game takes input, the other level while it is loading.
+//
+// A table step marks its wait with UNTIL_READY(): after the press it waits
+// until the pin has gone busy and then settled back to ready for
+// FEEDBACK_SETTLE_MS, or until the wait runs out, whichever comes first.
+// Without FEEDBACK_INPUT, or without anything on the pin, such a step simply
+// waits its full time as before.
+//
+// A wait that runs out is only a timeout (the console never loaded, so the
+// press was probably dropped) once the pin has gone busy at least once.
+// Until then nothing seems to drive it, and such waits are counted apart in
+// never_busy, so that an unwired pin does not make Resync_Due() back out on
+// every loop.
+//
+// The default pin is PB4, on the UNO R3's 16U2 header. ALERT_WHEN_DONE
+// toggles all of PORTB, which here only flips the pin's pull-up, so use a
+// driven (push-pull) signal.
+#ifndef FEEDBACK_BIT
+#define FEEDBACK_PIN  PINB
+#define FEEDBACK_PORT PORTB
+#define FEEDBACK_DDR  DDRB
+#define FEEDBACK_BIT  4
+#endif
+#ifndef FEEDBACK_READY_LEVEL
+#define FEEDBACK_READY_LEVEL 1
+#endif
+#define FEEDBACK_SETTLE_MS 20
+
+// Flag in a BUTTON_MAP_t wait_time; the rest is the timeout, up to 32767 ms.
+#define FEEDBACK_UNTIL_READY 0x8000
+#define UNTIL_READY(ms) (FEEDBACK_UNTIL_READY | (ms))
+
+typedef struct {
+  uint16_t early;    // waits the pin ended early
+  uint16_t timeouts;   // waits that ran their full time on a pin seen busy before
+  uint16_t never_busy; // waits that ran their full time before the pin was ever busy
+  uint32_t saved_ms; // time the early ones saved
+} FEEDBACK_STATS_t;
+
+extern FEEDBACK_STATS_t feedback_stats;
+
+// Makes the pin an input with its pull-up on, so that an unconnected pin
+// reads high and never ends a wait; call after the ALERT_WHEN_DONE port setup.
+void Feedback_Init(void);
+
+// delay() for a wait_time that may carry UNTIL_READY().
+void Feedback_Wait(uint16_t wait_time);
+
+#endif
@@ -0,0 +1,63 @@
+#include "grid.h"
+
+static uint8_t rows(const GRID_t *grid) {
+    return (grid->count + grid->columns - 1) / grid->columns;
+}
+
+static uint8_t row_length(const GRID_t *grid, uint8_t row) {
+    if (row == rows(grid) - 1 && grid->count % grid->columns)
+        return grid->count % grid->columns;
+    return grid->columns;
+}
+
+// -1, 0 or +1: which way to go from `from` to `to` on a line of `length` cells.
+static int8_t direction(uint8_t from, uint8_t to, uint8_t length, bool wrap) {
+    uint8_t forward;
+
+    if (from == to)
+        return 0;
+    if (!wrap)
+        return to > from ? 1 : -1;
+    forward = (to + length - from) % length;
+    return forward <= length - forward ? 1 : -1;
+}
+
+static bool wrap_rows(const GRID_t *grid) {
+    // Wrapping into a short last row lands on a missing cell, so don't.
+    return (grid->flags & GRID_WRAP_ROWS) && grid->count % grid->columns == 0;
+}
+
+ACTION_t Grid_Step(GRID_t *grid, uint8_t target) {
+    uint8_t row = grid->cursor / grid->columns, column = grid->cursor % grid->columns;
+    uint8_t total = rows(grid), length;
+    int8_t step;
+
+    if (target >= grid->count || target == grid->cursor)
+        return BUTTON_RESET;
+
+    step = direction(row, target / grid->columns, total, wrap_rows(grid));
+    if (step) {
+        uint8_t next = (row + total + step) % total;
+        // Going down into a short last row first needs a column that exists there.
+        if (next * grid->columns + column < grid->count) {
+            grid->cursor = next * grid->columns + column;
+            return step > 0 ? PAD_BOTTOM : PAD_TOP;
+        }
+    }
+
+    length = row_length(grid, row);
+    step = direction(column, target % grid->columns, length, grid->flags & GRID_WRAP_COLUMNS);
+    column = (column + length + step) % length;
+    grid->cursor = row * grid->columns + column;
+    return step > 0 ? PAD_RIGHT : PAD_LEFT;
+}
+
+uint8_t Grid_Distance(const GRID_t *grid, uint8_t from, uint8_t to) {
+    GRID_t walk = *grid;
+    uint8_t presses = 0;
+
+    walk.cursor = from;
+    while (Grid_Step(&walk, to) != BUTTON_RESET)
+        presses++;
+    return presses;
+}
@@ -0,0 +1,36 @@
+#ifndef _GRID_H_
+#define _GRID_H_
+
+#include "action.h"
+
+// Cursor of an in-game menu laid out as a grid, filled row by row: cell n is
+// at row n / columns, column n % columns, and only the last row may be short.
+// Grid_Step() walks the cursor to a cell one D-pad press at a time along a
+// shortest path, so picking several cells in a row only costs the distance
+// between them instead of a walk from the first cell each time.
+typedef struct {
+  uint8_t columns;
+  uint8_t count;  // cells in the menu
+  uint8_t flags;  // GRID_WRAP_*
+  uint8_t cursor; // cell the game's cursor is on
+} GRID_t;
+
+#define GRID_WRAP_ROWS    0x01 // top and bottom rows are neighbours; only used when the last row is full
+#define GRID_WRAP_COLUMNS 0x02 // left and right ends of a row are neighbours
+
+// Static initializer, cursor on the first cell.
+#define GRID(columns, count, flags) {(columns), (count), (flags), 0}
+
+// Tell the grid where the game put the cursor, e.g. 0 after opening the menu.
+static inline void Grid_Reset(GRID_t *grid, uint8_t cell) {
+  grid->cursor = cell;
+}
+
+// Next PAD_* press towards `target`, with the cursor already moved past it;
+// BUTTON_RESET once the cursor is there. Rows are walked before columns.
+ACTION_t Grid_Step(GRID_t *grid, uint8_t target);
+
+// Number of presses Grid_Step() takes from one cell to another.
+uint8_t Grid_Distance(const GRID_t *grid, uint8_t from, uint8_t to);
+
+#endif
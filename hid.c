@@ -0,0 +1,358 @@
+/** \file
+ *
+ *  USB plumbing shared by all programs: endpoint setup, control requests and
+ *  HID_Task(), which hands the reports built by GetNextReport() to the host.
+ *
+ *  Built with USB_ISR_MODE (make with-usb-isr), control requests are serviced
+ *  from the USB interrupt (INTERRUPT_CONTROL_ENDPOINT) and the IN endpoint is
+ *  fed from the Start-of-Frame interrupt. The main loop then only precomputes
+ *  the next report into a buffer, so enumeration and GetReport stay
+ *  responsive even while a program sits in a blocking delay().
+ *
+ *  Built with HOST_STREAM (make with-stream), OUT packets carrying stream
+ *  commands feed stream.c, whose frames take over the IN reports while it
+ *  plays, and a Feature GetReport returns the stream status.
+ *
+ *  Built with UART_STREAM (make with-uart), the same commands arrive on
+ *  USART1 instead, e.g. from the UNO's 328P; see uart.c.
+ *
+ *  In every build, Feature report PARAMS_REPORT_ID reads and writes the
+ *  EEPROM parameters of params.c. TELEMETRY builds add TELEMETRY_REPORT_ID,
+ *  which returns what the board is doing, see telemetry.h; STATS builds
+ *  STATS_REPORT_ID, which reads or clears the counters of stats.c in programs
+ *  that keep them; EVENTLOG builds EVENTLOG_REPORT_ID for the event ring of
+ *  eventlog.h; and PROFILE builds PROFILE_REPORT_ID for the cycle counts of
+ *  profile.h.
+ */
+
+#include "Joystick.h"
+#include "eventlog.h"
+#include "params.h"
+#include "profile.h"
+#include "stats.h"
+#include "telemetry.h"
+#if defined(HOST_STREAM) || defined(UART_STREAM)
+#define STREAM_PLAYER
+#include "stream.h"
+#endif
+#ifdef UART_STREAM
+#include "uart.h"
+#endif
+
+// The report most recently handed to the host; answers GetReport requests.
+static USB_JoystickReport_Input_t LastReport = {
+    .HAT = HAT_CENTER,
+    .LX = STICK_CENTER, .LY = STICK_CENTER, .RX = STICK_CENTER, .RY = STICK_CENTER,
+};
+
+// A parameter write from a SetReport, saved by HID_Task() since the EEPROM
+// is too slow to write from a control request.
+static PARAMS_SET_REPORT_t PendingParam;
+static volatile bool PendingParamReady = false;
+
+#ifdef STATS
+// See stats.h; set by programs that call Stats_Init().
+void (*volatile stats_report_hook)(STATS_REPORT_t *report);
+volatile bool stats_reset_requested;
+#endif
+
+// Feature reports carry their type in the high byte of wValue, one above
+// LUFA's item numbering, and the report ID in the low byte.
+#define FEATURE_REPORT(id) ((uint16_t) (HID_REPORT_ITEM_Feature + 1) << 8 | (id))
+
+#ifdef USB_ISR_MODE
+// Precomputed by HID_Task(), sent from the SOF interrupt.
+static USB_JoystickReport_Input_t NextReport;
+static volatile bool NextReportReady = false;
+#endif
+
+// Fired to indicate that the device is enumerating.
+void EVENT_USB_Device_Connect(void) {
+    // We can indicate that we're enumerating here (via status LEDs, sound, etc.).
+    EventLog_Add(EVENTLOG_CONNECT, 0);
+}
+
+// Fired to indicate that the device is no longer connected to a host.
+void EVENT_USB_Device_Disconnect(void) {
+    // We can indicate that our device is not ready (via status LEDs, sound, etc.).
+    EventLog_Add(EVENTLOG_DISCONNECT, 0);
+}
+
+// Fired when the host resets the bus, on enumeration and when it gives up on us.
+void EVENT_USB_Device_Reset(void) {
+    EventLog_Add(EVENTLOG_BUS_RESET, 0);
+}
+
+// Fired when the host set the current configuration of the USB device after enumeration.
+void EVENT_USB_Device_ConfigurationChanged(void) {
+    bool ConfigSuccess = true;
+
+    // We setup the HID report endpoints.
+    ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
+    ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
+#ifdef USB_ISR_MODE
+    // Every frame start gives us a chance to refill the IN endpoint.
+    USB_Device_EnableSOFEvents();
+#endif
+
+#ifdef UART_STREAM
+    // Only take stream commands once there is a host to play them to.
+    Uart_Init();
+#endif
+
+    // We can read ConfigSuccess to indicate a success or failure at this point.
+    if (!ConfigSuccess)
+        EventLog_Add(EVENTLOG_CONFIG_FAILED, 0);
+}
+
+// Process control requests sent to the device from the USB host.
+void EVENT_USB_Device_ControlRequest(void) {
+    // We can handle two control requests: a GetReport and a SetReport.
+    // The Switch does not seem to send either, but a PC might.
+    switch (USB_ControlRequest.bRequest) {
+        // GetReport is a request for data from the device.
+        case HID_REQ_GetReport:
+            if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE)) {
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(PARAMS_REPORT_ID)) {
+                    PARAMS_REPORT_t Params;
+                    Params_Report(&Params);
+                    Endpoint_ClearSETUP();
+                    Endpoint_Write_Control_Stream_LE(&Params, sizeof(Params));
+                    Endpoint_ClearOUT();
+                    break;
+                }
+#ifdef TELEMETRY
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(TELEMETRY_REPORT_ID)) {
+                    TELEMETRY_REPORT_t Telemetry;
+                    Telemetry_Report(&Telemetry);
+#ifdef STREAM_PLAYER
+                    STREAM_STATUS_t StreamStatus;
+                    Stream_GetStatus(&StreamStatus);
+                    Telemetry.stream_underruns = StreamStatus.underruns;
+                    Telemetry.stream_errors = StreamStatus.errors;
+#endif
+                    Endpoint_ClearSETUP();
+                    Endpoint_Write_Control_Stream_LE(&Telemetry, sizeof(Telemetry));
+                    Endpoint_ClearOUT();
+                    break;
+                }
+#endif
+#ifdef EVENTLOG
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(EVENTLOG_REPORT_ID)) {
+                    // Straight from the ring; an event logged meanwhile may show half written.
+                    Endpoint_ClearSETUP();
+                    Endpoint_Write_Control_Stream_LE(EventLog_Report(), sizeof(EVENTLOG_REPORT_t));
+                    Endpoint_ClearOUT();
+                    break;
+                }
+#endif
+#ifdef PROFILE
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(PROFILE_REPORT_ID)) {
+                    Endpoint_ClearSETUP();
+                    Endpoint_Write_Control_Stream_LE(Profile_Report(), sizeof(PROFILE_REPORT_t));
+                    Endpoint_ClearOUT();
+                    break;
+                }
+#endif
+#ifdef STATS
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(STATS_REPORT_ID) && stats_report_hook) {
+                    STATS_REPORT_t Stats;
+                    stats_report_hook(&Stats);
+                    Endpoint_ClearSETUP();
+                    Endpoint_Write_Control_Stream_LE(&Stats, sizeof(Stats));
+                    Endpoint_ClearOUT();
+                    break;
+                }
+#endif
+#ifdef STREAM_PLAYER
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(0)) {
+                    STREAM_STATUS_t StreamStatus;
+                    Stream_GetStatus(&StreamStatus);
+                    Endpoint_ClearSETUP();
+                    Endpoint_Write_Control_Stream_LE(&StreamStatus, sizeof(StreamStatus));
+                    Endpoint_ClearOUT();
+                    break;
+                }
+#endif
+                // We answer with the last report sent rather than advancing the program,
+                // which must not run from here (this may be interrupt context).
+                Endpoint_ClearSETUP();
+                Endpoint_Write_Control_Stream_LE(&LastReport, sizeof(LastReport));
+                Endpoint_ClearOUT();
+            }
+            break;
+        case HID_REQ_SetReport:
+            if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE)) {
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(PARAMS_REPORT_ID)) {
+                    // Stalled while the last write is still waiting for HID_Task(), or if the
+                    // program does not read this parameter or the value is out of range, so
+                    // the host sees it was not taken.
+                    if (PendingParamReady) {
+                        Endpoint_StallTransaction();
+                        break;
+                    }
+                    Endpoint_ClearSETUP();
+                    Endpoint_Read_Control_Stream_LE(&PendingParam, sizeof(PendingParam));
+                    if (!Params_Valid(PendingParam.id, PendingParam.value)) {
+                        Endpoint_StallTransaction();
+                        break;
+                    }
+                    Endpoint_ClearIN();
+                    PendingParamReady = true;
+                    break;
+                }
+#ifdef STATS
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(STATS_REPORT_ID) && stats_report_hook) {
+                    // Just the report ID; writing it means "clear".
+                    uint8_t ReportID;
+                    Endpoint_ClearSETUP();
+                    Endpoint_Read_Control_Stream_LE(&ReportID, sizeof(ReportID));
+                    Endpoint_ClearIN();
+                    stats_reset_requested = true;
+                    break;
+                }
+#endif
+#ifdef EVENTLOG
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(EVENTLOG_REPORT_ID)) {
+                    uint8_t ReportID;
+                    Endpoint_ClearSETUP();
+                    Endpoint_Read_Control_Stream_LE(&ReportID, sizeof(ReportID));
+                    Endpoint_ClearIN();
+                    EventLog_Clear();
+                    break;
+                }
+#endif
+#ifdef PROFILE
+                if (USB_ControlRequest.wValue == FEATURE_REPORT(PROFILE_REPORT_ID)) {
+                    uint8_t ReportID;
+                    Endpoint_ClearSETUP();
+                    Endpoint_Read_Control_Stream_LE(&ReportID, sizeof(ReportID));
+                    Endpoint_ClearIN();
+                    Profile_Reset();
+                    break;
+                }
+#endif
+                // We'll create a place to store our data received from the host.
+                USB_JoystickReport_Output_t JoystickOutputData;
+                // Since this is a control endpoint, we need to clear up the SETUP packet on this endpoint.
+                Endpoint_ClearSETUP();
+                // With our report available, we read data from the control stream.
+                Endpoint_Read_Control_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData));
+                // We then send an IN packet on this endpoint.
+                Endpoint_ClearIN();
+            }
+            break;
+    }
+}
+
+#ifdef USB_ISR_MODE
+// Fired from the USB interrupt at the start of every 1 ms frame.
+void EVENT_USB_Device_StartOfFrame(void) {
+    // The main loop may be halfway through an OUT endpoint access.
+    uint8_t PrevSelectedEndpoint = Endpoint_GetCurrentEndpoint();
+
+    Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
+    if (Endpoint_IsINReady()) {
+        if (NextReportReady) {
+            PROFILE_BEGIN(PROFILE_WRITE_STREAM);
+            Endpoint_Write_Stream_LE(&NextReport, sizeof(NextReport), NULL);
+            PROFILE_END(PROFILE_WRITE_STREAM);
+            Endpoint_ClearIN();
+            LastReport = NextReport;
+            NextReportReady = false;
+            TELEMETRY_ADD(reports, 1);
+        } else {
+            TELEMETRY_ADD(in_busy, 1);
+        }
+    }
+    Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+}
+#endif
+
+// The next IN report, from the stream if one is playing.
+static void FillReport(USB_JoystickReport_Input_t *const ReportData) {
+#ifdef STREAM_PLAYER
+    // Streamed frames take precedence while the host has playback started.
+    if (Stream_NextReport(ReportData))
+        return;
+#endif
+    PROFILE_BEGIN(PROFILE_GET_NEXT_REPORT);
+    GetNextReport(ReportData);
+    PROFILE_END(PROFILE_GET_NEXT_REPORT);
+}
+
+// Process and deliver data from IN and OUT endpoints.
+void HID_Task(void) {
+    // If the device isn't connected and properly configured, we can't do anything here.
+    if (USB_DeviceState != DEVICE_STATE_Configured)
+        return;
+    PROFILE_BEGIN(PROFILE_HID_TASK);
+    if (PendingParamReady) {
+        Params_Set(PendingParam.id, PendingParam.value);
+        PendingParamReady = false;
+    }
+#ifdef UART_STREAM
+    // Turn whatever the USART received into stream commands before picking the next report.
+    Uart_Task();
+#endif
+
+    // We'll start with the OUT endpoint.
+    Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
+    // We'll check to see if we received something on the OUT endpoint.
+    if (Endpoint_IsOUTReceived()) {
+        // If we did, and the packet has data, we'll react to it.
+        if (Endpoint_IsReadWriteAllowed()) {
+#ifdef HOST_STREAM
+            // A PC may send a whole packet of stream commands; the Switch's own output reports
+            // never start with STREAM_MAGIC and are dropped as before.
+            uint8_t Packet[JOYSTICK_EPSIZE];
+            uint8_t Length = Endpoint_BytesInEndpoint();
+            if (Length > sizeof(Packet))
+                Length = sizeof(Packet);
+            while (Endpoint_Read_Stream_LE(Packet, Length, NULL) != ENDPOINT_RWSTREAM_NoError);
+            if (Length && Packet[0] == STREAM_MAGIC)
+                Stream_Command(Packet, Length);
+#else
+            // We'll create a place to store our data received from the host.
+            USB_JoystickReport_Output_t JoystickOutputData;
+            // We'll then take in that data, setting it up in our storage.
+            while (Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL) !=
+                   ENDPOINT_RWSTREAM_NoError);
+            // At this point, we can react to this data.
+
+            // However, since we're not doing anything with this data, we abandon it.
+#endif
+        }
+        // Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
+        Endpoint_ClearOUT();
+    }
+#ifdef USB_ISR_MODE
+    // The SOF interrupt sends the buffered report; refill it once it is gone.
+    if (!NextReportReady) {
+        FillReport(&NextReport);
+        NextReportReady = true;
+    }
+#else
+    // We'll then move on to the IN endpoint.
+    Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
+    // We first check to see if the host is ready to accept data.
+    if (Endpoint_IsINReady()) {
+        // We'll create an empty report.
+        USB_JoystickReport_Input_t JoystickInputData;
+        // We'll then populate this report with what we want to send to the host.
+        FillReport(&JoystickInputData);
+        // Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
+        PROFILE_BEGIN(PROFILE_WRITE_STREAM);
+        while (Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL) !=
+               ENDPOINT_RWSTREAM_NoError);
+        PROFILE_END(PROFILE_WRITE_STREAM);
+        // We then send an IN packet on this endpoint.
+        Endpoint_ClearIN();
+        LastReport = JoystickInputData;
+        TELEMETRY_ADD(reports, 1);
+    } else {
+        TELEMETRY_ADD(in_busy, 1);
+    }
+#endif
+    PROFILE_END(PROFILE_HID_TASK);
+}
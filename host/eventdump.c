@@ -0,0 +1,173 @@
+/*
+ * eventdump - print the event ring of a board (eventlog.h) as a timeline.
+ *
+ *   eventdump /dev/hidrawN             oldest event first
+ *   eventdump -w run.bin /dev/hidrawN  also save the raw report
+ *   eventdump -f run.bin [-p eatMeat]  print a saved one
+ *   eventdump -r /dev/hidrawN          clear it
+ *
+ * Needs a build with EVENTLOG (make with-eventlog), through Feature report
+ * EVENTLOG_REPORT_ID. Times are the board's uptime; the program's name comes
+ * from its telemetry report, if it was built with TELEMETRY too, or -p, and
+ * turns state numbers into names. The board only keeps the gap to the event
+ * before, up to 65 s, so times before a longer gap are marked "~" and are
+ * later than the real ones.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "eventlog.h"
+#include "telemetry.h"
+#include "states.h"
+
+// Large enough for a board built with a bigger EVENTLOG_SIZE.
+#define MAX_EVENTS 64
+
+typedef struct __attribute__((packed)) {
+    EVENTLOG_REPORT_t header;
+    EVENTLOG_EVENT_t more[MAX_EVENTS - EVENTLOG_SIZE];
+} DUMP_t;
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-r] [-w file] [-p program] /dev/hidrawN\n"
+                    "       %s -f file [-p program]\n", name, name);
+    exit(2);
+}
+
+static void print_time(uint32_t ms) {
+    printf("%3lu:%02lu:%02lu.%03lu", (unsigned long) (ms / 3600000), (unsigned long) (ms / 60000 % 60),
+           (unsigned long) (ms / 1000 % 60), (unsigned long) (ms % 1000));
+}
+
+static void print_event(const char *program, const EVENTLOG_EVENT_t *event) {
+    switch (event->kind) {
+        case EVENTLOG_STATE: printf("state %s", state_name(program, event->value)); break;
+        case EVENTLOG_STEP: printf("  step %u%s", event->value, event->value == EVENTLOG_STEP_MAX ? "+" : ""); break;
+        case EVENTLOG_CONNECT: printf("usb connect"); break;
+        case EVENTLOG_DISCONNECT: printf("usb disconnect"); break;
+        case EVENTLOG_BUS_RESET: printf("usb bus reset"); break;
+        case EVENTLOG_CONFIG_FAILED: printf("usb configuration failed"); break;
+        case EVENTLOG_UNDERRUN: printf("stream underrun x%u", event->value); break;
+        case EVENTLOG_STREAM_ERROR: printf("stream error x%u", event->value); break;
+        case EVENTLOG_FEEDBACK_TIMEOUT: printf("feedback timeout"); break;
+        case EVENTLOG_RESYNC: printf("resync (%s)", event->value ? "asked for" : "scheduled"); break;
+        default: printf("event %u, %u", event->kind, event->value); break;
+    }
+    printf("\n");
+}
+
+static void print_dump(const char *program, const DUMP_t *dump, size_t length) {
+    const EVENTLOG_REPORT_t *log = &dump->header;
+    const EVENTLOG_EVENT_t *events = log->events;
+    uint32_t times[MAX_EVENTS];
+    bool guessed[MAX_EVENTS];
+    unsigned size = log->size, count = log->count, start, i;
+
+    if (length < sizeof(*log) - sizeof(log->events) || !size || size > MAX_EVENTS || count > size ||
+        log->head >= size || length < sizeof(*log) - sizeof(log->events) + size * sizeof(EVENTLOG_EVENT_t)) {
+        fprintf(stderr, "not an event log report\n");
+        exit(1);
+    }
+    start = count < size ? 0 : log->head;
+
+    printf("%s, up ", program[0] ? program : "?");
+    print_time(log->now_ms);
+    printf(", %u of %u events\n", count, size);
+    if (!count)
+        return;
+
+    // The newest event has an absolute time; walk back from it.
+    for (i = count; i-- > 0;) {
+        const EVENTLOG_EVENT_t *next = &events[(start + i + 1) % size];
+        times[i] = i == count - 1 ? log->last_ms : times[i + 1] - next->dt_ms;
+        guessed[i] = i == count - 1 ? false : guessed[i + 1] || next->dt_ms == EVENTLOG_DT_MAX;
+    }
+    printf("%14s %8s  %s\n", "uptime", "+ms", "event");
+    for (i = 0; i < count; i++) {
+        const EVENTLOG_EVENT_t *event = &events[(start + i) % size];
+        printf("%s", guessed[i] ? "~" : " ");
+        print_time(times[i]);
+        printf(" %7u%s ", event->dt_ms, event->dt_ms == EVENTLOG_DT_MAX ? "+" : " ");
+        print_event(program, event);
+    }
+    printf("%14s %7lu   now\n", "", (unsigned long) (log->now_ms - log->last_ms));
+}
+
+int main(int argc, char **argv) {
+    DUMP_t dump;
+    char program[sizeof(((TELEMETRY_REPORT_t *) 0)->program) + 1] = "";
+    const char *file = NULL, *save = NULL;
+    bool reset = false;
+    ssize_t length;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "rw:f:p:")) != -1) {
+        switch (opt) {
+            case 'r': reset = true; break;
+            case 'w': save = optarg; break;
+            case 'f': file = optarg; break;
+            case 'p': snprintf(program, sizeof(program), "%s", optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    memset(&dump, 0, sizeof(dump));
+
+    if (file) {
+        FILE *in;
+
+        if (optind != argc || reset || save)
+            usage(argv[0]);
+        in = fopen(file, "rb");
+        if (!in) {
+            perror(file);
+            return 1;
+        }
+        length = fread(&dump, 1, sizeof(dump), in);
+        fclose(in);
+        print_dump(program, &dump, length);
+        return 0;
+    }
+
+    if (optind != argc - 1)
+        usage(argv[0]);
+    fd = open(argv[optind], O_RDWR);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (reset) {
+        uint8_t id = EVENTLOG_REPORT_ID;
+        if (ioctl(fd, HIDIOCSFEATURE(sizeof(id)), &id) < 0) {
+            perror("HIDIOCSFEATURE");
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!program[0]) {
+        TELEMETRY_REPORT_t telemetry = {.report_id = TELEMETRY_REPORT_ID};
+        if (ioctl(fd, HIDIOCGFEATURE(sizeof(telemetry)), &telemetry) >= 0)
+            memcpy(program, telemetry.program, sizeof(telemetry.program));
+    }
+    dump.header.report_id = EVENTLOG_REPORT_ID;
+    length = ioctl(fd, HIDIOCGFEATURE(sizeof(dump)), &dump);
+    if (length < 0) {
+        perror("HIDIOCGFEATURE (is this a with-eventlog build?)");
+        return 1;
+    }
+    if (save) {
+        FILE *out = fopen(save, "wb");
+        if (!out || fwrite(&dump, 1, length, out) != (size_t) length || fclose(out)) {
+            perror(save);
+            return 1;
+        }
+    }
+    print_dump(program, &dump, length);
+    return 0;
+}
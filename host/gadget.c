@@ -0,0 +1,242 @@
+/*
+ * gadget - run a program's report engine as a Linux USB gadget (raw-gadget).
+ *
+ *   make gadget PROGRAM=aaa
+ *   sudo modprobe dummy_hcd raw_gadget        # or a real UDC, e.g. on a Pi Zero
+ *   sudo ./gadget [-u driver] [-n device]     # default dummy_udc / dummy_udc.0
+ *   ./hidread /dev/hidrawN                    # on the host side of the bus
+ *
+ * The program, hid.c and Descriptors.c run unchanged on top of the host
+ * shim, with the shim's clock following the wall clock. This file only moves
+ * data between raw-gadget and the shim:
+ *  - ep0 requests: GET_DESCRIPTOR is answered from CALLBACK_USB_GetDescriptor(),
+ *    SET_CONFIGURATION enables the endpoints from the configuration
+ *    descriptor, and class requests go to EVENT_USB_Device_ControlRequest();
+ *  - an IN thread hands every report HID_Task() writes to the host;
+ *  - an OUT thread passes host OUT packets to HID_Task().
+ * The control and endpoint threads stand in for the USB interrupt, so the
+ * program may block in delay() as it does on the board.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/usb/ch9.h>
+#include <linux/usb/raw_gadget.h>
+
+#include "Joystick.h"
+#include "standin.h"
+
+// The program's own main(), renamed when it is compiled for the gadget.
+int Program_main(void);
+
+static int fd;
+static int ep_in = -1, ep_out = -1;
+
+struct ep0_io {
+    struct usb_raw_ep_io io;
+    uint8_t data[256];
+};
+
+static void die(const char *what) {
+    perror(what);
+    exit(1);
+}
+
+static int enable_endpoint(const USB_Descriptor_Endpoint_t *endpoint) {
+    struct usb_endpoint_descriptor desc = {
+        .bLength = USB_DT_ENDPOINT_SIZE,
+        .bDescriptorType = USB_DT_ENDPOINT,
+        .bEndpointAddress = endpoint->EndpointAddress,
+        .bmAttributes = endpoint->Attributes,
+        .wMaxPacketSize = endpoint->EndpointSize,
+        .bInterval = endpoint->PollingIntervalMS,
+    };
+    int handle = ioctl(fd, USB_RAW_IOCTL_EP_ENABLE, &desc);
+    if (handle < 0)
+        die("USB_RAW_IOCTL_EP_ENABLE");
+    return handle;
+}
+
+static void *in_thread(void *arg) {
+    struct {
+        struct usb_raw_ep_io io;
+        USB_JoystickReport_Input_t report;
+    } packet = {.io = {.ep = ep_in, .length = sizeof(USB_JoystickReport_Input_t)}};
+
+    (void) arg;
+    for (;;) {
+        if (!Standin_In(&packet.report, sizeof(packet.report))) {
+            usleep(250);
+            continue;
+        }
+        // Blocks until the host polls the endpoint.
+        if (ioctl(fd, USB_RAW_IOCTL_EP_WRITE, &packet) < 0)
+            die("USB_RAW_IOCTL_EP_WRITE");
+    }
+    return NULL;
+}
+
+static void *out_thread(void *arg) {
+    struct {
+        struct usb_raw_ep_io io;
+        uint8_t data[JOYSTICK_EPSIZE];
+    } packet;
+    int length;
+
+    (void) arg;
+    for (;;) {
+        packet.io = (struct usb_raw_ep_io) {.ep = ep_out, .length = sizeof(packet.data)};
+        length = ioctl(fd, USB_RAW_IOCTL_EP_READ, &packet);
+        if (length < 0)
+            die("USB_RAW_IOCTL_EP_READ");
+        // Like the endpoint NAKing until HID_Task() has read the last packet.
+        while (!Standin_Out(packet.data, length))
+            usleep(250);
+    }
+    return NULL;
+}
+
+static void configure(void) {
+    const USB_Descriptor_Configuration_t *config;
+    pthread_t thread;
+
+    if (ep_in >= 0)
+        return;
+    if (!CALLBACK_USB_GetDescriptor(DTYPE_Configuration << 8, 0, (const void **) &config))
+        return;
+    ep_in = enable_endpoint(&config->HID_ReportINEndpoint);
+    ep_out = enable_endpoint(&config->HID_ReportOUTEndpoint);
+    if (ioctl(fd, USB_RAW_IOCTL_VBUS_DRAW, config->Config.MaxPowerConsumption) < 0)
+        die("USB_RAW_IOCTL_VBUS_DRAW");
+    if (ioctl(fd, USB_RAW_IOCTL_CONFIGURE, 0) < 0)
+        die("USB_RAW_IOCTL_CONFIGURE");
+
+    USB_DeviceState = DEVICE_STATE_Configured;
+    EVENT_USB_Device_ConfigurationChanged();
+    pthread_create(&thread, NULL, in_thread, NULL);
+    pthread_create(&thread, NULL, out_thread, NULL);
+}
+
+// Answers one request on ep0; false to stall it.
+static bool control(const struct usb_ctrlrequest *setup) {
+    struct ep0_io reply = {.io = {.ep = 0}};
+    uint16_t length = setup->wLength < sizeof(reply.data) ? setup->wLength : sizeof(reply.data);
+    bool in = setup->bRequestType & USB_DIR_IN;
+    int answer;
+
+    if ((setup->bRequestType & USB_TYPE_MASK) == USB_TYPE_STANDARD) {
+        switch (setup->bRequest) {
+            case USB_REQ_GET_DESCRIPTOR: {
+                const void *address;
+                uint16_t size = CALLBACK_USB_GetDescriptor(setup->wValue, setup->wIndex, &address);
+                if (!size)
+                    return false;
+                reply.io.length = size < length ? size : length;
+                memcpy(reply.data, address, reply.io.length);
+                break;
+            }
+            case USB_REQ_SET_CONFIGURATION:
+                configure();
+                break;
+            case USB_REQ_GET_CONFIGURATION:
+                reply.data[0] = ep_in >= 0;
+                reply.io.length = 1;
+                break;
+            case USB_REQ_GET_STATUS:
+                reply.io.length = length < 2 ? length : 2;
+                break;
+            case USB_REQ_SET_INTERFACE:
+                break;
+            default:
+                return false;
+        }
+    } else if (in) {
+        answer = Standin_Control(setup->bRequestType, setup->bRequest, setup->wValue, setup->wIndex,
+                                 reply.data, length);
+        if (answer < 0)
+            return false;
+        reply.io.length = answer;
+    } else {
+        // Reading the data stage also completes the request, so there is no
+        // stalling it afterwards; only data-less requests can be refused.
+        if (length) {
+            reply.io.length = length;
+            if (ioctl(fd, USB_RAW_IOCTL_EP0_READ, &reply) < 0)
+                die("USB_RAW_IOCTL_EP0_READ");
+        }
+        answer = Standin_Control(setup->bRequestType, setup->bRequest, setup->wValue, setup->wIndex,
+                                 reply.data, length);
+        if (length)
+            return true;
+        if (answer < 0)
+            return false;
+    }
+
+    if (in) {
+        if (ioctl(fd, USB_RAW_IOCTL_EP0_WRITE, &reply) < 0)
+            die("USB_RAW_IOCTL_EP0_WRITE");
+    } else {
+        // A zero-length read acknowledges the status stage.
+        reply.io.length = 0;
+        if (ioctl(fd, USB_RAW_IOCTL_EP0_READ, &reply) < 0)
+            die("USB_RAW_IOCTL_EP0_READ");
+    }
+    return true;
+}
+
+static void *control_thread(void *arg) {
+    struct {
+        struct usb_raw_event event;
+        struct usb_ctrlrequest setup;
+    } event;
+
+    (void) arg;
+    for (;;) {
+        event.event.type = 0;
+        event.event.length = sizeof(event.setup);
+        if (ioctl(fd, USB_RAW_IOCTL_EVENT_FETCH, &event) < 0)
+            die("USB_RAW_IOCTL_EVENT_FETCH");
+        if (event.event.type == USB_RAW_EVENT_CONNECT)
+            EVENT_USB_Device_Connect();
+        else if (event.event.type == USB_RAW_EVENT_CONTROL && !control(&event.setup))
+            ioctl(fd, USB_RAW_IOCTL_EP0_STALL, 0);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    struct usb_raw_init init = {.speed = USB_SPEED_FULL};
+    const char *driver = "dummy_udc", *device = "dummy_udc.0";
+    pthread_t thread;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "u:n:")) != -1) {
+        switch (opt) {
+            case 'u': driver = optarg; break;
+            case 'n': device = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-u udc driver] [-n udc device]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    fd = open("/dev/raw-gadget", O_RDWR);
+    if (fd < 0)
+        die("/dev/raw-gadget");
+    strncpy((char *) init.driver_name, driver, UDC_NAME_LENGTH_MAX - 1);
+    strncpy((char *) init.device_name, device, UDC_NAME_LENGTH_MAX - 1);
+    if (ioctl(fd, USB_RAW_IOCTL_INIT, &init) < 0)
+        die("USB_RAW_IOCTL_INIT");
+    if (ioctl(fd, USB_RAW_IOCTL_RUN, 0) < 0)
+        die("USB_RAW_IOCTL_RUN");
+
+    USB_DeviceState = DEVICE_STATE_Powered;
+    Standin_RealTime();
+    pthread_create(&thread, NULL, control_thread, NULL);
+    return Program_main();
+}
@@ -0,0 +1,74 @@
+/*
+ * hidread - print the reports a controller sends, as a trace.
+ *
+ *   hidread [-a] [-n count] /dev/hidrawN
+ *
+ * Reads the 8-byte input reports of the board, or of gadget running on
+ * dummy_hcd, and prints one trace line per report that differs from the one
+ * before (every report with -a):
+ *   <time_us> <button hex> <hat> <lx> <ly> <rx> <ry>
+ * Time counts from the first report. Stops after -n reports if given.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "Joystick.h"
+
+static unsigned long long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char **argv) {
+    USB_JoystickReport_Input_t report, last;
+    struct hidraw_devinfo info;
+    unsigned long long start = 0, count = 0, limit = 0;
+    bool all = false;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "an:")) != -1) {
+        switch (opt) {
+            case 'a': all = true; break;
+            case 'n': limit = strtoull(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-a] [-n count] /dev/hidrawN\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "usage: %s [-a] [-n count] /dev/hidrawN\n", argv[0]);
+        return 2;
+    }
+    fd = open(argv[optind], O_RDONLY);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (ioctl(fd, HIDIOCGRAWINFO, &info) == 0)
+        printf("# %04x:%04x\n", (unsigned) info.vendor & 0xFFFF, (unsigned) info.product & 0xFFFF);
+
+    while (!limit || count < limit) {
+        if (read(fd, &report, sizeof(report)) != sizeof(report)) {
+            perror("read");
+            return 1;
+        }
+        if (!count)
+            start = now_us();
+        if (all || !count || memcmp(&report, &last, sizeof(report))) {
+            printf("%llu %04x %u %u %u %u %u\n", now_us() - start, report.Button, report.HAT, report.LX,
+                   report.LY, report.RX, report.RY);
+            fflush(stdout);
+        }
+        last = report;
+        count++;
+    }
+    return 0;
+}
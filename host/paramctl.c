@@ -0,0 +1,217 @@
+/*
+ * paramctl - read or change the EEPROM parameters of a board (params.h).
+ *
+ *   paramctl /dev/hidrawN [NAME VALUE]...   list them, after saving each
+ *                                           NAME VALUE; NAME or its number
+ *   paramctl -p PROGRAM [NAME VALUE]...     the same against the in-process
+ *                                           stand-in, keeping PROGRAM's
+ *                                           parameters (eatMeat, mission...)
+ *
+ * Works with every build, through Feature report PARAMS_REPORT_ID. Programs
+ * read their parameters when they start, except where noted in params.h.
+ * Only the running program's parameters can be set, and only to values in
+ * range (Params_InRange()). The board saves a value from its main loop,
+ * which a program may leave for seconds at a time, so this waits (up to
+ * TIMEOUT_MS) until the value reads back. Stops at the first value that is
+ * not taken, exiting 1.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "Joystick.h"
+#include "params.h"
+#include "timer.h"
+#include "standin.h"
+
+#define TIMEOUT_MS 30000
+#define POLL_MS    100
+
+#define PARAMS_FEATURE ((HID_REPORT_ITEM_Feature + 1) << 8 | PARAMS_REPORT_ID)
+
+static const char *const names[PARAM_COUNT] = {
+    [PARAM_BLADE_NUM] = "blade_num",
+    [PARAM_BLADE_POS] = "blade_pos",
+    [PARAM_MISSION_TIME] = "mission_time",
+};
+
+static const char *const programs[] = {
+    [PARAMS_NONE] = "none",
+    [PARAMS_EAT_MEAT] = "eatMeat",
+    [PARAMS_MISSION] = "mission",
+    [PARAMS_MISSION_ALL] = "missionAll",
+    [PARAMS_TO_SS] = "toSS",
+};
+
+#define PROGRAM_COUNT (sizeof(programs) / sizeof(*programs))
+
+static int device = -1;
+
+// The stand-in runs no program of its own: it stays neutral.
+void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
+    memset(ReportData, 0, sizeof(*ReportData));
+    ReportData->HAT = HAT_CENTER;
+    ReportData->LX = ReportData->LY = ReportData->RX = ReportData->RY = STICK_CENTER;
+}
+
+static void read_params(PARAMS_REPORT_t *report) {
+    memset(report, 0, sizeof(*report));
+    report->report_id = PARAMS_REPORT_ID;
+    if (device < 0) {
+        Standin_Control(REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE, HID_REQ_GetReport,
+                        PARAMS_FEATURE, 0, report, sizeof(*report));
+        return;
+    }
+    if (ioctl(device, HIDIOCGFEATURE(sizeof(*report)), report) < 0) {
+        perror("HIDIOCGFEATURE");
+        exit(1);
+    }
+}
+
+// Sends the write; false if the board stalled it.
+static bool write_param(PARAMS_SET_REPORT_t *set) {
+    if (device < 0)
+        return Standin_Control(REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE, HID_REQ_SetReport,
+                               PARAMS_FEATURE, 0, set, sizeof(*set)) >= 0;
+    if (ioctl(device, HIDIOCSFEATURE(sizeof(*set)), set) >= 0)
+        return true;
+    if (errno != EPIPE) {
+        perror("HIDIOCSFEATURE");
+        exit(1);
+    }
+    return false;
+}
+
+// Lets the board run for POLL_MS; the stand-in runs its main loop that long.
+static void poll_wait(void) {
+    USB_JoystickReport_Input_t report;
+    int ms;
+
+    if (device >= 0) {
+        usleep(POLL_MS * 1000);
+        return;
+    }
+    for (ms = 0; ms < POLL_MS; ms++) {
+        HID_Task();
+        Standin_In(&report, sizeof(report));
+        Standin_Tick();
+    }
+}
+
+static int usage(const char *name) {
+    fprintf(stderr, "usage: %s /dev/hidrawN | -p PROGRAM [NAME VALUE]...\n", name);
+    return 2;
+}
+
+static const char *program_name(uint8_t program) {
+    return program < PROGRAM_COUNT ? programs[program] : "?";
+}
+
+// Sends the write, again while the board is still saving an earlier one
+// (it stalls the request then), and waits for the value to read back.
+static int set_param(uint8_t id, uint16_t value) {
+    PARAMS_SET_REPORT_t set = {PARAMS_REPORT_ID, id, value};
+    PARAMS_REPORT_t report;
+    uint16_t values[PARAM_COUNT];
+    int waited;
+
+    read_params(&report);
+    if (!(report.used & (1 << id))) {
+        fprintf(stderr, "%s does not read %s\n", program_name(report.program), names[id]);
+        return 1;
+    }
+    for (waited = 0; !write_param(&set); waited += POLL_MS) {
+        // A stall is a refusal unless the value is fine and the board is busy.
+        read_params(&report);
+        memcpy(values, report.values, sizeof(values));
+        if (!Params_InRange(id, value, report.set, values)) {
+            fprintf(stderr, "%s %u refused: out of range\n", names[id], value);
+            return 1;
+        }
+        if (waited >= TIMEOUT_MS) {
+            fprintf(stderr, "%s not taken after %d s; is the program stuck?\n", names[id], TIMEOUT_MS / 1000);
+            return 1;
+        }
+        poll_wait();
+    }
+    for (; waited < TIMEOUT_MS; waited += POLL_MS) {
+        read_params(&report);
+        if ((report.set & (1 << id)) && report.values[id] == value)
+            return 0;
+        poll_wait();
+    }
+    fprintf(stderr, "%s not saved after %d s; is the program stuck?\n", names[id], TIMEOUT_MS / 1000);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    const char *standin = NULL, *path = NULL;
+    PARAMS_REPORT_t report;
+    int opt, id, arg;
+    unsigned program;
+    unsigned long value;
+
+    while ((opt = getopt(argc, argv, "p:")) != -1) {
+        switch (opt) {
+            case 'p': standin = optarg; break;
+            default: return usage(argv[0]);
+        }
+    }
+    if (!standin) {
+        if (optind >= argc)
+            return usage(argv[0]);
+        path = argv[optind++];
+    }
+    if ((argc - optind) % 2)
+        return usage(argv[0]);
+
+    if (standin) {
+        for (program = 0; program < PROGRAM_COUNT && strcmp(standin, programs[program]); program++);
+        if (program == PROGRAM_COUNT) {
+            fprintf(stderr, "unknown program %s\n", standin);
+            return 2;
+        }
+        Timer_Init();
+        USB_Init();
+        Params_Init(program);
+        EVENT_USB_Device_ConfigurationChanged();
+    } else if ((device = open(path, O_RDWR)) < 0) {
+        perror(path);
+        return 1;
+    }
+
+    for (arg = optind; arg < argc; arg += 2) {
+        for (id = 0; id < PARAM_COUNT && strcmp(argv[arg], names[id]); id++);
+        if (id == PARAM_COUNT)
+            id = atoi(argv[arg]);
+        if (id < 0 || id >= PARAM_COUNT) {
+            fprintf(stderr, "unknown parameter %s\n", argv[arg]);
+            return 2;
+        }
+        value = strtoul(argv[arg + 1], NULL, 0);
+        if (value > UINT16_MAX) {
+            fprintf(stderr, "%s %s refused: out of range\n", names[id], argv[arg + 1]);
+            return 1;
+        }
+        if (set_param(id, value))
+            return 1;
+    }
+
+    read_params(&report);
+    printf("program %s\n", program_name(report.program));
+    for (id = 0; id < PARAM_COUNT; id++) {
+        if (!(report.used & (1 << id)))
+            printf("%d %-14s not used\n", id, names[id]);
+        else if (report.set & (1 << id))
+            printf("%d %-14s %u\n", id, names[id], report.values[id]);
+        else
+            printf("%d %-14s default\n", id, names[id]);
+    }
+    return 0;
+}
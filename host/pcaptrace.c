@@ -0,0 +1,322 @@
+/*
+ * pcaptrace - turn a usbmon capture of the board into a trace.
+ *
+ *   sudo modprobe usbmon
+ *   sudo tcpdump -i usbmonN -w run.pcap      # or Wireshark, pcap or pcapng
+ *   pcaptrace [-a] [-b bus] [-d device] [-i ms] run.pcap > run.trace
+ *
+ * Takes the completed interrupt IN transfers of 8 bytes, the board's input
+ * reports, and prints them as hidread and sim-PROGRAM do, one line per change
+ * (every report with -a):
+ *   <time_us> <button hex> <hat> <lx> <ly> <rx> <ry>
+ * Time counts from the first report, by the host's usbmon clock. A keyboard
+ * sends 8-byte reports too, so if more than one device does, the capture is
+ * refused with their addresses; pick the board with -b and -d.
+ *
+ * Then prints to stderr how the host actually polled: the interval between
+ * reports with its spread, and the polls missed, counting a gap of n
+ * intervals as n - 1 dropped. The expected interval is -i ms, or else the
+ * median one seen.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PCAP_MAGIC_US 0xa1b2c3d4
+#define PCAP_MAGIC_NS 0xa1b23c4d
+#define PCAPNG_SHB    0x0a0d0d0a
+#define PCAPNG_BOM    0x1a2b3c4d
+#define PCAPNG_IDB    1
+#define PCAPNG_EPB    6
+
+#define LINKTYPE_USB_LINUX         189 // 48-byte usbmon header
+#define LINKTYPE_USB_LINUX_MMAPPED 220 // 64-byte usbmon header
+
+#define USBMON_HEADER   48
+#define USBMON_COMPLETE 'C'
+#define USBMON_INTR     1
+#define USBMON_IN       0x80
+
+#define REPORT_SIZE 8
+#define MAX_INTERFACES 16
+#define MAX_DEVICES 16
+
+static FILE *in;
+static bool swapped;
+static bool all;
+static int want_bus = -1, want_device = -1;
+
+// Devices sending reports, found by a first pass over the capture.
+static struct {
+    int bus, device;
+    unsigned long reports;
+} devices[MAX_DEVICES];
+static int device_count;
+static bool scanning;
+
+static unsigned long long first_us, last_us;
+static unsigned long reports;
+static uint8_t last[REPORT_SIZE];
+
+// Gaps between reports, in us.
+static unsigned long long *gaps;
+static size_t gap_count, gap_size;
+
+static uint16_t get16(const uint8_t *p) {
+    return swapped ? p[0] << 8 | p[1] : p[1] << 8 | p[0];
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return swapped ? (uint32_t) p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3]
+                   : (uint32_t) p[3] << 24 | p[2] << 16 | p[1] << 8 | p[0];
+}
+
+static uint64_t get64(const uint8_t *p) {
+    return swapped ? (uint64_t) get32(p) << 32 | get32(p + 4) : (uint64_t) get32(p + 4) << 32 | get32(p);
+}
+
+static bool read_exactly(void *data, size_t length) {
+    return fread(data, 1, length, in) == length;
+}
+
+static void add_gap(unsigned long long us) {
+    if (gap_count == gap_size) {
+        gap_size = gap_size ? gap_size * 2 : 4096;
+        gaps = realloc(gaps, gap_size * sizeof(*gaps));
+        if (!gaps) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    gaps[gap_count++] = us;
+}
+
+// One captured packet: a usbmon header and what of the data was captured.
+static void packet(const uint8_t *data, uint32_t length, int linktype) {
+    uint32_t header = linktype == LINKTYPE_USB_LINUX_MMAPPED ? 64 : USBMON_HEADER;
+    unsigned long long us;
+    const uint8_t *report;
+
+    if (length < header + REPORT_SIZE)
+        return;
+    // id, type, transfer type, endpoint, device, bus, setup and data flags.
+    if (data[8] != USBMON_COMPLETE || data[9] != USBMON_INTR || !(data[10] & USBMON_IN))
+        return;
+    // status, then the URB's and the captured length.
+    if (get32(data + 28) != 0 || get32(data + 36) != REPORT_SIZE)
+        return;
+    if ((want_bus >= 0 && get16(data + 12) != want_bus) || (want_device >= 0 && data[11] != want_device))
+        return;
+    if (scanning) {
+        int i;
+        for (i = 0; i < device_count && (devices[i].bus != get16(data + 12) || devices[i].device != data[11]); i++);
+        if (i == device_count && device_count < MAX_DEVICES) {
+            devices[i].bus = get16(data + 12);
+            devices[i].device = data[11];
+            device_count++;
+        }
+        if (i < device_count)
+            devices[i].reports++;
+        return;
+    }
+    if (!reports)
+        printf("# usbmon bus %d device %d endpoint 0x%02x\n", get16(data + 12), data[11], data[10]);
+
+    us = get64(data + 16) * 1000000ULL + get32(data + 24);
+    report = data + header;
+    if (reports)
+        add_gap(us - last_us);
+    else
+        first_us = us;
+    if (all || !reports || memcmp(report, last, REPORT_SIZE))
+        printf("%llu %04x %u %u %u %u %u\n", us - first_us, report[0] | report[1] << 8, report[2], report[3],
+               report[4], report[5], report[6]);
+    memcpy(last, report, REPORT_SIZE);
+    last_us = us;
+    reports++;
+}
+
+static uint8_t *record(uint32_t length) {
+    static uint8_t *buffer;
+    static uint32_t size;
+
+    if (length > size) {
+        size = length;
+        buffer = realloc(buffer, size);
+        if (!buffer) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    return read_exactly(buffer, length) ? buffer : NULL;
+}
+
+static bool read_pcap(uint32_t magic) {
+    uint8_t header[20], entry[16], *data;
+    int linktype;
+
+    swapped = magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS;
+    if (!read_exactly(header, sizeof(header)))
+        return false;
+    linktype = get32(header + 16) & 0xFFFF;
+    if (linktype != LINKTYPE_USB_LINUX && linktype != LINKTYPE_USB_LINUX_MMAPPED) {
+        fprintf(stderr, "link type %d is not usbmon\n", linktype);
+        return false;
+    }
+    while (read_exactly(entry, sizeof(entry))) {
+        uint32_t captured = get32(entry + 8);
+        if (!(data = record(captured)))
+            break;
+        packet(data, captured, linktype);
+    }
+    return true;
+}
+
+static bool read_pcapng(void) {
+    int linktypes[MAX_INTERFACES];
+    unsigned interfaces = 0;
+    uint8_t head[8], *body;
+
+    rewind(in);
+    while (read_exactly(head, sizeof(head))) {
+        uint32_t type, length;
+
+        // A section header's type reads the same both ways round; its byte-order magic doesn't.
+        if (get32(head) == PCAPNG_SHB) {
+            uint8_t bom[4];
+            if (!read_exactly(bom, sizeof(bom)))
+                return false;
+            swapped = get32(bom) != PCAPNG_BOM;
+            length = get32(head + 4);
+            if (length < 12 || !record(length - 12))
+                return false;
+            interfaces = 0;
+            continue;
+        }
+        type = get32(head);
+        length = get32(head + 4);
+        if (length < 12 || !(body = record(length - 8)))
+            return false;
+        if (type == PCAPNG_IDB && interfaces < MAX_INTERFACES)
+            linktypes[interfaces++] = get16(body);
+        if (type == PCAPNG_EPB && length >= 32) {
+            uint32_t interface = get32(body), captured = get32(body + 12);
+            if (interface < interfaces && 20 + captured <= length - 8 &&
+                (linktypes[interface] == LINKTYPE_USB_LINUX || linktypes[interface] == LINKTYPE_USB_LINUX_MMAPPED))
+                packet(body + 20, captured, linktypes[interface]);
+        }
+    }
+    return true;
+}
+
+static int compare(const void *a, const void *b) {
+    unsigned long long x = *(const unsigned long long *) a, y = *(const unsigned long long *) b;
+    return x < y ? -1 : x > y;
+}
+
+static void print_polling(double expected_ms) {
+    unsigned long long expected, dropped = 0, late = 0, sum = 0;
+    double mean, variance = 0;
+    size_t i;
+
+    fprintf(stderr, "%lu reports over %.3f s\n", reports, (last_us - first_us) / 1e6);
+    if (!gap_count)
+        return;
+
+    for (i = 0; i < gap_count; i++)
+        sum += gaps[i];
+    mean = (double) sum / gap_count;
+    for (i = 0; i < gap_count; i++)
+        variance += (gaps[i] - mean) * (gaps[i] - mean);
+    qsort(gaps, gap_count, sizeof(*gaps), compare);
+    expected = expected_ms > 0 ? expected_ms * 1000 : gaps[gap_count / 2];
+
+    for (i = 0; i < gap_count; i++) {
+        // Rounded to whole intervals, so that jitter alone drops nothing.
+        unsigned long long intervals = expected ? (gaps[i] + expected / 2) / expected : 1;
+        if (intervals > 1) {
+            dropped += intervals - 1;
+            late++;
+        }
+    }
+    fprintf(stderr, "interval: mean %.3f ms, median %.3f, min %.3f, max %.3f, jitter %.3f ms (sd)\n",
+            mean / 1000, gaps[gap_count / 2] / 1000.0, gaps[0] / 1000.0, gaps[gap_count - 1] / 1000.0,
+            sqrt(variance / gap_count) / 1000);
+    fprintf(stderr, "dropped: %llu polls of %.3f ms in %llu gaps (%.2f%%)\n", dropped, expected / 1000.0, late,
+            100.0 * dropped / (gap_count + dropped));
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-a] [-b bus] [-d device] [-i ms] capture.pcap[ng]\n", name);
+    exit(2);
+}
+
+// One pass over the capture, pcap or pcapng, from the start.
+static bool read_capture(const char *path) {
+    uint8_t magic[4];
+    uint32_t value;
+
+    rewind(in);
+    if (!read_exactly(magic, sizeof(magic))) {
+        fprintf(stderr, "%s: empty\n", path);
+        return false;
+    }
+    swapped = false;
+    value = get32(magic);
+    if (value == PCAPNG_SHB)
+        return read_pcapng();
+    if (value != PCAP_MAGIC_US && value != PCAP_MAGIC_NS && __builtin_bswap32(value) != PCAP_MAGIC_US &&
+        __builtin_bswap32(value) != PCAP_MAGIC_NS) {
+        fprintf(stderr, "%s: not a pcap or pcapng file\n", path);
+        return false;
+    }
+    return read_pcap(value);
+}
+
+int main(int argc, char **argv) {
+    double expected_ms = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ab:d:i:")) != -1) {
+        switch (opt) {
+            case 'a': all = true; break;
+            case 'b': want_bus = atoi(optarg); break;
+            case 'd': want_device = atoi(optarg); break;
+            case 'i': expected_ms = atof(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1)
+        usage(argv[0]);
+    in = fopen(argv[optind], "rb");
+    if (!in) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    scanning = true;
+    if (!read_capture(argv[optind]))
+        return 1;
+    if (!device_count) {
+        fprintf(stderr, "no %d-byte interrupt IN reports in %s\n", REPORT_SIZE, argv[optind]);
+        return 1;
+    }
+    if (device_count > 1) {
+        int i;
+        fprintf(stderr, "%s: more than one device sends %d-byte reports; pick one with -b and -d:\n",
+                argv[optind], REPORT_SIZE);
+        for (i = 0; i < device_count; i++)
+            fprintf(stderr, "  -b %d -d %d   %lu reports\n", devices[i].bus, devices[i].device, devices[i].reports);
+        return 1;
+    }
+    scanning = false;
+    if (!read_capture(argv[optind]))
+        return 1;
+    print_polling(expected_ms);
+    return 0;
+}
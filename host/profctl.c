@@ -0,0 +1,90 @@
+/*
+ * profctl - print or clear the hot-path cycle counts of a board (profile.h).
+ *
+ *   profctl /dev/hidrawN       per region: calls, min, mean, max, cycles per frame
+ *   profctl -r /dev/hidrawN    clear them, e.g. after the program has settled
+ *
+ * Needs a build with PROFILE (make with-profile), through Feature report
+ * PROFILE_REPORT_ID. Counts are CPU cycles; "us" columns convert them at the
+ * board's clock, and "frame" is the region's average cost in each 1 ms USB
+ * frame since the counters were cleared. Regions nest (GetNextReport() runs
+ * inside HID_Task()), so the shares don't add up.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "profile.h"
+
+static const char *const names[PROFILE_REGIONS] = {
+    "HID_Task", "GetNextReport", "setButton", "Endpoint_Write_Stream_LE", "USB_USBTask",
+};
+
+int main(int argc, char **argv) {
+    PROFILE_REPORT_t report;
+    bool reset = false;
+    int fd, opt, i;
+
+    while ((opt = getopt(argc, argv, "r")) != -1) {
+        switch (opt) {
+            case 'r': reset = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-r] /dev/hidrawN\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-r] /dev/hidrawN\n", argv[0]);
+        return 2;
+    }
+    fd = open(argv[optind], O_RDWR);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (reset) {
+        uint8_t id = PROFILE_REPORT_ID;
+        if (ioctl(fd, HIDIOCSFEATURE(sizeof(id)), &id) < 0) {
+            perror("HIDIOCSFEATURE");
+            return 1;
+        }
+        return 0;
+    }
+
+    memset(&report, 0, sizeof(report));
+    report.report_id = PROFILE_REPORT_ID;
+    if (ioctl(fd, HIDIOCGFEATURE(sizeof(report)), &report) < 0) {
+        perror("HIDIOCGFEATURE (is this a with-profile build?)");
+        return 1;
+    }
+    if (report.count > PROFILE_REGIONS)
+        report.count = PROFILE_REGIONS;
+    if (!report.cycles_per_ms)
+        report.cycles_per_ms = 16000;
+
+    printf("%-26s %10s %9s %9s %9s %9s %7s %6s\n", "region", "calls", "min", "mean", "max", "mean us", "frame",
+           "share");
+    for (i = 0; i < report.count; i++) {
+        const PROFILE_STATS_t *region = &report.regions[i];
+        double mean = region->count ? (double) region->total / region->count : 0.0;
+        double frame = report.ms ? (double) region->total / report.ms : 0.0;
+
+        printf("%-26s %10lu", names[i], (unsigned long) region->count);
+        if (!region->count) {
+            printf("\n");
+            continue;
+        }
+        printf(" %9lu %9.0f %9lu %9.1f %7.0f %5.1f%%\n", (unsigned long) region->min, mean,
+               (unsigned long) region->max, mean * 1000.0 / report.cycles_per_ms, frame,
+               100.0 * frame / report.cycles_per_ms);
+    }
+    printf("over %.1f s at %u cycles per ms; each region measures about %u more than it takes\n",
+           report.ms / 1000.0, report.cycles_per_ms, report.overhead);
+    return 0;
+}
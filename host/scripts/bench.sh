@@ -0,0 +1,55 @@
+#!/bin/sh
+# Run every program as sim-PROGRAM for the same stretch of virtual time and
+# compare what it sent with golden.txt, so that a change to action.c, hid.c
+# or a shared table that moves a press or a wait shows up here, with numbers.
+#
+#   scripts/bench.sh        compare; exits 1 if any program differs
+#   scripts/bench.sh -u     rewrite golden.txt after an intended change
+#
+# Columns are those of sim-PROGRAM -s, plus the wall time each run took,
+# which is only printed.
+set -e
+cd "$(dirname "$0")/.."
+
+programs="printImage eatMeat toSS mission missionAll openCard openPoint aaa"
+duration=600000
+golden=scripts/golden.txt
+
+update=false
+[ "$1" = "-u" ] && update=true
+
+out=$(mktemp)
+trap 'rm -f "$out"' EXIT
+
+printf '%-11s %8s %8s %8s %8s %9s %9s %-16s %s\n' \
+    program wall_ms reports changes last_ms report_us loop_us hash ""
+failed=0
+for p in $programs; do
+    make -s sim-$p > /dev/null 2>&1 || { echo "sim-$p does not build"; exit 1; }
+    start=$(date +%s%N)
+    got=$(./sim-$p -s -t $duration)
+    end=$(date +%s%N)
+    rm -f sim-$p
+    echo "$p $got" >> "$out"
+
+    want=
+    [ -f $golden ] && want=$(awk -v p=$p '$1 == p { $1 = ""; print substr($0, 2) }' $golden)
+    status=ok
+    if [ -z "$want" ]; then
+        status=new
+    elif [ "$want" != "$got" ]; then
+        status="CHANGED, was $want"
+        failed=1
+    fi
+    set -- $got
+    printf '%-11s %8d %8s %8s %8s %9s %9s %-16s %s\n' \
+        $p $(((end - start) / 1000000)) $1 $2 $3 $4 $5 $6 "$status"
+done
+
+if $update; then
+    { echo "# program reports changes last_ms report_us loop_us hash, over ${duration} ms (scripts/bench.sh -u)"
+      cat "$out"; } > $golden
+    echo "wrote $golden"
+    exit 0
+fi
+exit $failed
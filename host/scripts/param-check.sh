@@ -0,0 +1,47 @@
+#!/bin/sh
+# Set parameters through paramctl -p, against hid.c and params.c on the
+# stand-in, and check that values in range are saved and that the board
+# refuses the rest.
+set -e
+cd "$(dirname "$0")/.."
+
+failed=0
+
+# taken PROGRAM NAME VALUE...: every value is saved and listed
+taken() {
+    if ! out=$(./paramctl -p "$@"); then
+        echo "$*: refused"
+        failed=1
+        return
+    fi
+    shift
+    while [ $# -gt 0 ]; do
+        echo "$out" | grep -q "^[0-9] $1 *$2\$" || { echo "$1 $2 not listed"; failed=1; }
+        shift 2
+    done
+}
+
+# refused PROGRAM NAME VALUE...: the last value is not taken
+refused() {
+    if ./paramctl -p "$@" > /dev/null 2>&1; then
+        echo "$*: taken"
+        failed=1
+    fi
+}
+
+taken eatMeat blade_num 26 blade_pos 3
+taken eatMeat blade_pos 25 blade_num 26
+taken mission mission_time 45
+taken missionAll mission_time 1440
+refused eatMeat blade_num 1
+refused eatMeat blade_pos 0
+refused eatMeat blade_num 10 blade_pos 10
+refused eatMeat blade_pos 6 blade_num 5
+refused mission mission_time 0
+refused mission mission_time 1441
+refused mission mission_time 65536
+refused mission blade_num 26
+refused toSS blade_num 26
+
+[ $failed = 0 ] && echo "parameters checked"
+exit $failed
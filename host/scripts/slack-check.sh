@@ -0,0 +1,35 @@
+#!/bin/sh
+# Tune toSS's eatPre[] with slack against a pretend console, built and run
+# as sim-toSS on the stand-in. The console takes each step's wait as long as
+# it is at least the made-up minimum below; the search must end on those,
+# rounded up to the 250 ms steps (the 50 ms PAD_LEFT is already that close).
+set -e
+cd "$(dirname "$0")/.."
+
+minimum="1200 700 800 1600 0"
+expect="1250 750 1000 1750 50"
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+./slack init -r 250 -n 1 ../toSS.c eatPre > "$dir/state"
+while grep -q '^testing' "$dir/state"; do
+    ./slack table -p "$dir/state" > "$dir/toSS.c"
+    make -s sim-toSS SIM_DIR="$dir" -B > /dev/null 2>&1
+    ./sim-toSS -t 200000 > "$dir/trace"
+    step=$(awk '/^testing/ { print $3 }' "$dir/state")
+    candidate=$(awk '/^testing/ { print $4 }' "$dir/state")
+    need=$(echo $minimum | cut -d' ' -f$((step + 1)))
+    result=pass
+    [ "$candidate" -ge "$need" ] || result=fail
+    echo "$result $result" > "$dir/results"
+    ./slack run "$dir/state" "$dir/trace" "$dir/results" | tail -n 2
+done
+rm -f sim-toSS
+
+got=$(./slack table -f -m 0 "$dir/state" | sed -n 's/.*, *\([0-9]*\)}.*/\1/p' | tr '\n' ' ')
+if [ "$got" != "$expect " ]; then
+    echo "eatPre tuned to $got, expected $expect"
+    exit 1
+fi
+echo "eatPre tuned to $got"
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Run the offline trace tools on the captures and traces in traces/ and
+# compare what they print, stdout then stderr and the exit status, with the
+# .out file next to each case.
+#
+#   scripts/trace-check.sh      compare; exits 1 on any difference
+#   scripts/trace-check.sh -u   rewrite the .out files after an intended change
+#
+# board.pcap and board.pcapng are synthetic: 60 polls of the board (bus 3,
+# device 5) every 8 ms, +-0.1 ms, with one poll dropped before the 21st and
+# two before the 41st. The pcapng also holds a keyboard on device 7.
+# eatMeat.trace is ./sim-eatMeat -m -t 120000, the first loop with its states.
+set -e
+cd "$(dirname "$0")/.."
+
+update=false
+[ "$1" = "-u" ] && update=true
+
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+failed=0
+
+# check NAME COMMAND...
+check() {
+    name=$1
+    shift
+    status=0
+    "$@" > "$dir/out" 2> "$dir/err" || status=$?
+    { cat "$dir/out" "$dir/err"; echo "exit $status"; } > "$dir/got"
+    if $update; then
+        cp "$dir/got" scripts/traces/$name.out
+    elif ! diff -u scripts/traces/$name.out "$dir/got"; then
+        echo "$name: differs"
+        failed=1
+    else
+        echo "$name: ok"
+    fi
+}
+
+check pcap ./pcaptrace scripts/traces/board.pcap
+check pcap-all ./pcaptrace -a -i 8 scripts/traces/board.pcap
+check pcapng-two ./pcaptrace scripts/traces/board.pcapng
+check pcapng ./pcaptrace -b 3 -d 5 scripts/traces/board.pcapng
+check tracestat-polls sh -c "./pcaptrace -a scripts/traces/board.pcap 2> /dev/null | ./tracestat -"
+check tracestat ./tracestat -n 3 scripts/traces/eatMeat.trace
+check tracestat-vcd sh -c "head -n 40 scripts/traces/eatMeat.trace | ./tracestat -v $dir/vcd - > /dev/null && cat $dir/vcd"
+
+exit $failed
@@ -0,0 +1,27 @@
+#!/bin/sh
+# Run streamctl scripts over a pty against uartdev, the with-uart stand-in.
+# With -d the files are played by streamd instead.
+set -e
+cd "$(dirname "$0")/.."
+
+tool=./streamctl
+if [ "$1" = "-d" ]; then
+    tool=./streamd
+    shift
+fi
+
+fifo=$(mktemp -u)
+mkfifo "$fifo"
+./uartdev > "$fifo" &
+dev=$!
+trap 'kill $dev 2>/dev/null; rm -f "$fifo"' EXIT
+
+exec 3< "$fifo"
+read -r pty <&3
+if [ "$tool" = ./streamd ]; then
+    $tool -s "$pty" "$@"
+else
+    for script in "$@"; do
+        $tool -s "$pty" "$script"
+    done
+fi
@@ -0,0 +1,143 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <util/delay.h>
+
+#define ATTR_PACKED __attribute__((packed))
+#define ATTR_WARN_UNUSED_RESULT __attribute__((warn_unused_result))
+#define ATTR_NON_NULL_PTR_ARG(...) __attribute__((nonnull(__VA_ARGS__)))
+#define ATTR_WEAK __attribute__((weak))
+#define ARCH_AVR8 0
+#define ARCH ARCH_AVR8
+#define GlobalInterruptEnable() ((void)0)
+#define GlobalInterruptDisable() ((void)0)
+
+typedef struct ATTR_PACKED { uint8_t Size; uint8_t Type; } USB_Descriptor_Header_t;
+typedef struct ATTR_PACKED {
+  USB_Descriptor_Header_t Header; uint16_t USBSpecification; uint8_t Class, SubClass, Protocol, Endpoint0Size;
+  uint16_t VendorID, ProductID, ReleaseNumber; uint8_t ManufacturerStrIndex, ProductStrIndex, SerialNumStrIndex, NumberOfConfigurations;
+} USB_Descriptor_Device_t;
+typedef struct ATTR_PACKED {
+  USB_Descriptor_Header_t Header; uint16_t TotalConfigurationSize; uint8_t TotalInterfaces, ConfigurationNumber, ConfigurationStrIndex, ConfigAttributes, MaxPowerConsumption;
+} USB_Descriptor_Configuration_Header_t;
+typedef struct ATTR_PACKED {
+  USB_Descriptor_Header_t Header; uint8_t InterfaceNumber, AlternateSetting, TotalEndpoints, Class, SubClass, Protocol, InterfaceStrIndex;
+} USB_Descriptor_Interface_t;
+typedef struct ATTR_PACKED {
+  USB_Descriptor_Header_t Header; uint8_t EndpointAddress, Attributes; uint16_t EndpointSize; uint8_t PollingIntervalMS;
+} USB_Descriptor_Endpoint_t;
+typedef struct ATTR_PACKED {
+  USB_Descriptor_Header_t Header; uint16_t HIDSpec; uint8_t CountryCode, TotalReportDescriptors, HIDReportType; uint16_t HIDReportLength;
+} USB_HID_Descriptor_HID_t;
+typedef struct ATTR_PACKED { USB_Descriptor_Header_t Header; uint16_t UnicodeString[]; } USB_Descriptor_String_t;
+typedef uint8_t USB_Descriptor_HIDReport_Datatype_t;
+typedef struct ATTR_PACKED { uint8_t bmRequestType, bRequest; uint16_t wValue, wIndex, wLength; } USB_Request_Header_t;
+
+#define VERSION_BCD(a, b, c) ((uint16_t)(((a) << 8) | ((b) << 4) | (c)))
+#define USB_CONFIG_POWER_MA(ma) ((ma) >> 1)
+#define LANGUAGE_ID_ENG 0x0409
+#define USB_STRING_LEN(n) (sizeof(USB_Descriptor_Header_t) + ((n) << 1))
+#define USB_STRING_DESCRIPTOR(s) { .Header = {.Size = sizeof(USB_Descriptor_Header_t) + (sizeof(s) - 2), .Type = DTYPE_String}, .UnicodeString = s }
+#define USB_STRING_DESCRIPTOR_ARRAY(...) { .Header = {.Size = sizeof(USB_Descriptor_Header_t) + sizeof((uint16_t[]){__VA_ARGS__}), .Type = DTYPE_String}, .UnicodeString = {__VA_ARGS__} }
+#define NO_DESCRIPTOR 0
+#define FIXED_CONTROL_ENDPOINT_SIZE 64
+#define FIXED_NUM_CONFIGURATIONS 1
+
+enum { DTYPE_Device = 1, DTYPE_Configuration = 2, DTYPE_String = 3, DTYPE_Interface = 4, DTYPE_Endpoint = 5 };
+#define HID_DTYPE_HID 0x21
+#define HID_DTYPE_Report 0x22
+#define USB_CSCP_NoDeviceClass 0
+#define USB_CSCP_NoDeviceSubclass 0
+#define USB_CSCP_NoDeviceProtocol 0
+#define HID_CSCP_HIDClass 3
+#define HID_CSCP_NonBootSubclass 0
+#define HID_CSCP_NonBootProtocol 0
+#define EP_TYPE_CONTROL 0
+#define EP_TYPE_INTERRUPT 3
+#define ENDPOINT_ATTR_NO_SYNC 0
+#define ENDPOINT_USAGE_DATA 0
+#define ENDPOINT_DIR_IN 0x80
+#define ENDPOINT_DIR_OUT 0x00
+#define ENDPOINT_CONTROLEP 0
+
+#define _HID_RI_DATA_SIZE_MASK 0x03
+#define _HID_RI_ENCODE_0(d)
+#define _HID_RI_ENCODE_8(d) , ((d) & 0xFF)
+#define _HID_RI_ENCODE_16(d) _HID_RI_ENCODE_8(d) _HID_RI_ENCODE_8((d) >> 8)
+#define _HID_RI_ENCODE_32(d) _HID_RI_ENCODE_16(d) _HID_RI_ENCODE_16((d) >> 16)
+#define _HID_RI_SIZE_0 0
+#define _HID_RI_SIZE_8 1
+#define _HID_RI_SIZE_16 2
+#define _HID_RI_SIZE_32 3
+#define _HID_RI_ENTRY(t, b, s, ...) (t | b | _HID_RI_SIZE_##s) _HID_RI_ENCODE_##s(__VA_ARGS__ + 0)
+#define HID_RI_INPUT(s, ...) _HID_RI_ENTRY(0x00, 0x80, s, __VA_ARGS__)
+#define HID_RI_OUTPUT(s, ...) _HID_RI_ENTRY(0x00, 0x90, s, __VA_ARGS__)
+#define HID_RI_COLLECTION(s, ...) _HID_RI_ENTRY(0x00, 0xA0, s, __VA_ARGS__)
+#define HID_RI_FEATURE(s, ...) _HID_RI_ENTRY(0x00, 0xB0, s, __VA_ARGS__)
+#define HID_RI_END_COLLECTION(s, ...) _HID_RI_ENTRY(0x00, 0xC0, s, __VA_ARGS__)
+#define HID_RI_USAGE_PAGE(s, ...) _HID_RI_ENTRY(0x04, 0x00, s, __VA_ARGS__)
+#define HID_RI_LOGICAL_MINIMUM(s, ...) _HID_RI_ENTRY(0x04, 0x10, s, __VA_ARGS__)
+#define HID_RI_LOGICAL_MAXIMUM(s, ...) _HID_RI_ENTRY(0x04, 0x20, s, __VA_ARGS__)
+#define HID_RI_PHYSICAL_MINIMUM(s, ...) _HID_RI_ENTRY(0x04, 0x30, s, __VA_ARGS__)
+#define HID_RI_PHYSICAL_MAXIMUM(s, ...) _HID_RI_ENTRY(0x04, 0x40, s, __VA_ARGS__)
+#define HID_RI_UNIT_EXPONENT(s, ...) _HID_RI_ENTRY(0x04, 0x50, s, __VA_ARGS__)
+#define HID_RI_UNIT(s, ...) _HID_RI_ENTRY(0x04, 0x60, s, __VA_ARGS__)
+#define HID_RI_REPORT_SIZE(s, ...) _HID_RI_ENTRY(0x04, 0x70, s, __VA_ARGS__)
+#define HID_RI_REPORT_ID(s, ...) _HID_RI_ENTRY(0x04, 0x80, s, __VA_ARGS__)
+#define HID_RI_REPORT_COUNT(s, ...) _HID_RI_ENTRY(0x04, 0x90, s, __VA_ARGS__)
+#define HID_RI_PUSH(s, ...) _HID_RI_ENTRY(0x04, 0xA0, s, __VA_ARGS__)
+#define HID_RI_POP(s, ...) _HID_RI_ENTRY(0x04, 0xB0, s, __VA_ARGS__)
+#define HID_RI_USAGE(s, ...) _HID_RI_ENTRY(0x08, 0x00, s, __VA_ARGS__)
+#define HID_RI_USAGE_MINIMUM(s, ...) _HID_RI_ENTRY(0x08, 0x10, s, __VA_ARGS__)
+#define HID_RI_USAGE_MAXIMUM(s, ...) _HID_RI_ENTRY(0x08, 0x20, s, __VA_ARGS__)
+
+enum USB_Device_States_t { DEVICE_STATE_Unattached, DEVICE_STATE_Powered, DEVICE_STATE_Default, DEVICE_STATE_Addressed, DEVICE_STATE_Configured, DEVICE_STATE_Suspended };
+extern volatile uint8_t USB_DeviceState;
+extern USB_Request_Header_t USB_ControlRequest;
+
+#define REQDIR_HOSTTODEVICE (0 << 7)
+#define REQDIR_DEVICETOHOST (1 << 7)
+#define REQTYPE_STANDARD (0 << 5)
+#define REQTYPE_CLASS (1 << 5)
+#define REQTYPE_VENDOR (2 << 5)
+#define REQREC_DEVICE 0
+#define REQREC_INTERFACE 1
+#define HID_REQ_GetReport 0x01
+#define HID_REQ_GetIdle 0x02
+#define HID_REQ_GetProtocol 0x03
+#define HID_REQ_SetReport 0x09
+#define HID_REQ_SetIdle 0x0A
+#define HID_REQ_SetProtocol 0x0B
+#define HID_REPORT_ITEM_In 0
+#define HID_REPORT_ITEM_Out 1
+#define HID_REPORT_ITEM_Feature 2
+
+enum Endpoint_Stream_RW_ErrorCodes_t { ENDPOINT_RWSTREAM_NoError = 0, ENDPOINT_RWSTREAM_EndpointStalled, ENDPOINT_RWSTREAM_DeviceDisconnected, ENDPOINT_RWSTREAM_BusSuspended, ENDPOINT_RWSTREAM_Timeout, ENDPOINT_RWSTREAM_IncompleteTransfer };
+
+void USB_Init(void);
+void USB_USBTask(void);
+void USB_Device_EnableSOFEvents(void);
+void USB_Device_DisableSOFEvents(void);
+bool Endpoint_ConfigureEndpoint(uint8_t Address, uint8_t Type, uint16_t Size, uint8_t Banks);
+void Endpoint_SelectEndpoint(uint8_t Address);
+uint8_t Endpoint_GetCurrentEndpoint(void);
+bool Endpoint_IsOUTReceived(void);
+bool Endpoint_IsINReady(void);
+bool Endpoint_IsReadWriteAllowed(void);
+bool Endpoint_IsSETUPReceived(void);
+uint16_t Endpoint_BytesInEndpoint(void);
+void Endpoint_ClearOUT(void);
+void Endpoint_ClearIN(void);
+void Endpoint_ClearSETUP(void);
+void Endpoint_ClearStatusStage(void);
+void Endpoint_StallTransaction(void);
+uint8_t Endpoint_Read_8(void);
+void Endpoint_Write_8(uint8_t Data);
+uint8_t Endpoint_Read_Stream_LE(void *Buffer, uint16_t Length, uint16_t *BytesProcessed);
+uint8_t Endpoint_Write_Stream_LE(const void *Buffer, uint16_t Length, uint16_t *BytesProcessed);
+uint8_t Endpoint_Read_Control_Stream_LE(void *Buffer, uint16_t Length);
+uint8_t Endpoint_Write_Control_Stream_LE(const void *Buffer, uint16_t Length);
+uint8_t Endpoint_Write_Control_PStream_LE(const void *Buffer, uint16_t Length);
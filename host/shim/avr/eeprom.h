@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#define EEMEM
+void eeprom_read_block(void *dst, const void *src, size_t n);
+void eeprom_update_block(const void *src, void *dst, size_t n);
+void eeprom_write_block(const void *src, void *dst, size_t n);
+#define eeprom_busy_wait() ((void)0)
@@ -0,0 +1,4 @@
+#pragma once
+#define ISR(vector, ...) void vector(void); void vector(void)
+#define sei() ((void)0)
+#define cli() ((void)0)
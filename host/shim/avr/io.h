@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+#define REG8(n) extern volatile uint8_t n;
+#define REG16(n) extern volatile uint16_t n;
+REG8(PORTB) REG8(DDRB) REG8(PINB) REG8(PORTD) REG8(DDRD) REG8(PIND) REG8(PORTC) REG8(DDRC) REG8(PINC)
+REG8(MCUSR) REG8(TCCR1A) REG8(TCCR1B) REG8(TIMSK1) REG8(TIFR1) REG8(SMCR)
+REG16(OCR1A) REG16(TCNT1)
+REG8(UCSR1A) REG8(UCSR1B) REG8(UCSR1C) REG8(UDR1) REG16(UBRR1)
+REG8(UDIEN) REG8(UEIENX) REG8(EECR) REG8(GPIOR0)
+#define WDRF 3
+#define WGM12 3
+#define CS10 0
+#define CS11 1
+#define OCIE1A 1
+#define RXEN1 4
+#define TXEN1 3
+#define RXCIE1 7
+#define UDRIE1 5
+#define RXC1 7
+#define UDRE1 5
+#define U2X1 1
+#define UCSZ10 1
+#define UCSZ11 2
+#define DOR1 3
+#define FE1 4
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define PORT0 0
+#define RAMEND 0x2FF
+#define _BV(b) (1 << (b))
+#define OCF1A 1
@@ -0,0 +1,7 @@
+#pragma once
+#define SLEEP_MODE_IDLE 0
+#define set_sleep_mode(m) ((void)(m))
+void sleep_mode(void);
+#define sleep_enable() ((void)0)
+#define sleep_disable() ((void)0)
+void sleep_cpu(void);
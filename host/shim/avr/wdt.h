@@ -0,0 +1,3 @@
+#pragma once
+#define wdt_disable() ((void)0)
+#define wdt_reset() ((void)0)
@@ -0,0 +1,306 @@
+#include <string.h>
+#include <time.h>
+
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include <util/delay.h>
+#include <LUFA/Drivers/USB/USB.h>
+
+#include "standin.h"
+
+#define REG_DEFINE8(n) volatile uint8_t n;
+#define REG_DEFINE16(n) volatile uint16_t n;
+REG_DEFINE8(PORTB) REG_DEFINE8(DDRB) REG_DEFINE8(PINB)
+REG_DEFINE8(PORTD) REG_DEFINE8(DDRD) REG_DEFINE8(PIND)
+REG_DEFINE8(PORTC) REG_DEFINE8(DDRC) REG_DEFINE8(PINC)
+REG_DEFINE8(MCUSR) REG_DEFINE8(TCCR1A) REG_DEFINE8(TCCR1B) REG_DEFINE8(TIMSK1) REG_DEFINE8(TIFR1) REG_DEFINE8(SMCR)
+REG_DEFINE16(OCR1A) REG_DEFINE16(TCNT1)
+REG_DEFINE8(UCSR1A) REG_DEFINE8(UCSR1B) REG_DEFINE8(UCSR1C) REG_DEFINE8(UDR1) REG_DEFINE16(UBRR1)
+REG_DEFINE8(UDIEN) REG_DEFINE8(UEIENX) REG_DEFINE8(EECR) REG_DEFINE8(GPIOR0)
+
+volatile uint8_t USB_DeviceState = DEVICE_STATE_Configured;
+USB_Request_Header_t USB_ControlRequest;
+
+// Provided by whichever firmware modules are linked in.
+void TIMER1_COMPA_vect(void) __attribute__((weak));
+void EVENT_USB_Device_StartOfFrame(void) __attribute__((weak));
+void EVENT_USB_Device_ControlRequest(void) __attribute__((weak));
+void USART1_RX_vect(void) __attribute__((weak));
+void USART1_UDRE_vect(void) __attribute__((weak));
+
+static uint32_t now;
+static bool real_time;
+static struct timespec epoch;
+
+uint32_t Standin_Millis(void) {
+    return now;
+}
+
+void Standin_RealTime(void) {
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    epoch.tv_sec -= now / 1000;
+    epoch.tv_nsec -= (now % 1000) * 1000000L;
+    real_time = true;
+}
+
+static uint32_t wall_millis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec - epoch.tv_sec) * 1000 + (ts.tv_nsec - epoch.tv_nsec) / 1000000;
+}
+
+// Sleep until the next tick is due, then catch up with the wall clock.
+static void sleep_tick(void) {
+    if (!real_time) {
+        Standin_Tick();
+        return;
+    }
+    while (wall_millis() <= now)
+        nanosleep(&(struct timespec) {0, 200000}, NULL);
+    while (wall_millis() > now)
+        Standin_Tick();
+}
+
+void Standin_Tick(void) {
+    now++;
+    TCNT1 = 0;
+    if (TIMER1_COMPA_vect)
+        TIMER1_COMPA_vect();
+    if (EVENT_USB_Device_StartOfFrame)
+        EVENT_USB_Device_StartOfFrame();
+}
+
+// Sleeping always lasts until the next tick here.
+void sleep_mode(void) {
+    sleep_tick();
+}
+
+void sleep_cpu(void) {
+    sleep_tick();
+}
+
+void _delay_ms(double ms) {
+    uint32_t until = now + (uint32_t) ms;
+    while ((int32_t) (now - until) < 0)
+        sleep_tick();
+}
+
+void _delay_us(double us) {
+    (void) us;
+}
+
+void Standin_UartRx(uint8_t data) {
+    if (!USART1_RX_vect || !(UCSR1B & _BV(RXCIE1)))
+        return;
+    UCSR1A &= ~(_BV(FE1) | _BV(DOR1));
+    UDR1 = data;
+    USART1_RX_vect();
+}
+
+bool Standin_UartTx(uint8_t *data) {
+    if (!USART1_UDRE_vect || !(UCSR1B & _BV(UDRIE1)))
+        return false;
+    // The ISR either writes UDR1 or, with nothing left, masks itself and returns.
+    USART1_UDRE_vect();
+    if (!(UCSR1B & _BV(UDRIE1)))
+        return false;
+    *data = UDR1;
+    return true;
+}
+
+static uint8_t eeprom[1024];
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+    memcpy(dst, eeprom + (uintptr_t) src % sizeof(eeprom), n);
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n) {
+    memcpy(eeprom + (uintptr_t) dst % sizeof(eeprom), src, n);
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n) {
+    eeprom_update_block(src, dst, n);
+}
+
+// Endpoints: one OUT packet, one IN packet and the control data stage, which
+// may span several packets on the bus (hence the size). The `full` flags hand
+// a packet between threads, so they are only accessed atomically and after
+// (or before) the data.
+#define BANK_SIZE 64
+
+typedef struct {
+    uint8_t data[256];
+    uint16_t length;
+    uint16_t pos;
+    bool full;
+} ENDPOINT_t;
+
+static ENDPOINT_t out_ep, in_ep, control_ep;
+static __thread uint8_t current;
+static bool control_taken;
+
+static bool is_full(ENDPOINT_t *ep) {
+    return __atomic_load_n(&ep->full, __ATOMIC_ACQUIRE);
+}
+
+static void set_full(ENDPOINT_t *ep, bool full) {
+    __atomic_store_n(&ep->full, full, __ATOMIC_RELEASE);
+}
+
+void USB_Init(void) {}
+void USB_USBTask(void) {}
+void USB_Device_EnableSOFEvents(void) {}
+void USB_Device_DisableSOFEvents(void) {}
+
+bool Endpoint_ConfigureEndpoint(uint8_t Address, uint8_t Type, uint16_t Size, uint8_t Banks) {
+    (void) Address; (void) Type; (void) Size; (void) Banks;
+    return true;
+}
+
+void Endpoint_SelectEndpoint(uint8_t Address) {
+    current = Address;
+}
+
+uint8_t Endpoint_GetCurrentEndpoint(void) {
+    return current;
+}
+
+static ENDPOINT_t *selected(void) {
+    if (current == ENDPOINT_CONTROLEP)
+        return &control_ep;
+    return (current & ENDPOINT_DIR_IN) ? &in_ep : &out_ep;
+}
+
+bool Endpoint_IsOUTReceived(void) {
+    return is_full(&out_ep);
+}
+
+bool Endpoint_IsINReady(void) {
+    return !is_full(&in_ep);
+}
+
+bool Endpoint_IsReadWriteAllowed(void) {
+    ENDPOINT_t *ep = selected();
+    return (ep == &in_ep) ? ep->pos < BANK_SIZE : ep->pos < ep->length;
+}
+
+bool Endpoint_IsSETUPReceived(void) {
+    return false;
+}
+
+uint16_t Endpoint_BytesInEndpoint(void) {
+    ENDPOINT_t *ep = selected();
+    return (ep == &in_ep) ? ep->pos : ep->length - ep->pos;
+}
+
+void Endpoint_ClearOUT(void) {
+    if (current != ENDPOINT_CONTROLEP) {
+        out_ep.length = out_ep.pos = 0;
+        set_full(&out_ep, false);
+    }
+}
+
+void Endpoint_ClearIN(void) {
+    if (current != ENDPOINT_CONTROLEP) {
+        in_ep.length = in_ep.pos;
+        set_full(&in_ep, true);
+    }
+}
+
+void Endpoint_ClearSETUP(void) {
+    control_taken = true;
+}
+void Endpoint_ClearStatusStage(void) {}
+void Endpoint_StallTransaction(void) {
+    control_taken = false;
+}
+
+uint8_t Endpoint_Read_8(void) {
+    ENDPOINT_t *ep = selected();
+    return ep->pos < ep->length ? ep->data[ep->pos++] : 0;
+}
+
+void Endpoint_Write_8(uint8_t Data) {
+    ENDPOINT_t *ep = selected();
+    if (ep->pos < sizeof(ep->data))
+        ep->data[ep->pos++] = Data;
+}
+
+uint8_t Endpoint_Read_Stream_LE(void *Buffer, uint16_t Length, uint16_t *BytesProcessed) {
+    uint8_t *p = Buffer;
+    while (Length--)
+        *p++ = Endpoint_Read_8();
+    if (BytesProcessed)
+        *BytesProcessed = p - (uint8_t *) Buffer;
+    return ENDPOINT_RWSTREAM_NoError;
+}
+
+uint8_t Endpoint_Write_Stream_LE(const void *Buffer, uint16_t Length, uint16_t *BytesProcessed) {
+    const uint8_t *p = Buffer;
+    while (Length--)
+        Endpoint_Write_8(*p++);
+    if (BytesProcessed)
+        *BytesProcessed = p - (const uint8_t *) Buffer;
+    return ENDPOINT_RWSTREAM_NoError;
+}
+
+uint8_t Endpoint_Read_Control_Stream_LE(void *Buffer, uint16_t Length) {
+    current = ENDPOINT_CONTROLEP;
+    return Endpoint_Read_Stream_LE(Buffer, Length, NULL);
+}
+
+uint8_t Endpoint_Write_Control_Stream_LE(const void *Buffer, uint16_t Length) {
+    current = ENDPOINT_CONTROLEP;
+    if (Length > USB_ControlRequest.wLength)
+        Length = USB_ControlRequest.wLength;
+    return Endpoint_Write_Stream_LE(Buffer, Length, NULL);
+}
+
+uint8_t Endpoint_Write_Control_PStream_LE(const void *Buffer, uint16_t Length) {
+    return Endpoint_Write_Control_Stream_LE(Buffer, Length);
+}
+
+bool Standin_Out(const void *data, uint8_t length) {
+    if (is_full(&out_ep))
+        return false;
+    if (length > BANK_SIZE)
+        length = BANK_SIZE;
+    memcpy(out_ep.data, data, length);
+    out_ep.length = length;
+    out_ep.pos = 0;
+    set_full(&out_ep, true);
+    return true;
+}
+
+bool Standin_In(void *data, uint8_t length) {
+    if (!is_full(&in_ep))
+        return false;
+    memcpy(data, in_ep.data, length < in_ep.length ? length : in_ep.length);
+    in_ep.length = in_ep.pos = 0;
+    set_full(&in_ep, false);
+    return true;
+}
+
+int Standin_Control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+                    uint16_t wIndex, void *data, uint16_t length) {
+    uint8_t previous = current;
+
+    USB_ControlRequest = (USB_Request_Header_t) {bmRequestType, bRequest, wValue, wIndex, length};
+    memset(&control_ep, 0, sizeof(control_ep));
+    control_taken = false;
+    if (!(bmRequestType & REQDIR_DEVICETOHOST)) {
+        control_ep.length = length < sizeof(control_ep.data) ? length : sizeof(control_ep.data);
+        memcpy(control_ep.data, data, control_ep.length);
+    }
+    if (EVENT_USB_Device_ControlRequest)
+        EVENT_USB_Device_ControlRequest();
+    current = previous;
+
+    if (!control_taken)
+        return -1;
+    if (!(bmRequestType & REQDIR_DEVICETOHOST))
+        return 0;
+    memcpy(data, control_ep.data, control_ep.pos);
+    return control_ep.pos;
+}
@@ -0,0 +1,45 @@
+#ifndef _STANDIN_H_
+#define _STANDIN_H_
+
+// Host stand-in for the board: backs the AVR registers and LUFA endpoint
+// calls used by the firmware with plain memory and a virtual 1 ms clock, so
+// firmware modules can be linked into PC tools and driven like the device.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Virtual time since start, in ms.
+uint32_t Standin_Millis(void);
+
+// Advance the clock by one tick: runs the Timer1 ISR and, if linked, the SOF event.
+void Standin_Tick(void);
+
+// From now on sleeping and _delay_ms() wait for the wall clock, which the
+// virtual one then follows, instead of returning at once.
+void Standin_RealTime(void);
+
+// Queue a packet on the OUT endpoint, as a host write would. False while the
+// previous one has not been read yet.
+bool Standin_Out(const void *data, uint8_t length);
+
+// Take the packet written to the IN endpoint, freeing it for the next one.
+bool Standin_In(void *data, uint8_t length);
+
+// Run a control request through EVENT_USB_Device_ControlRequest. For
+// device-to-host requests the answer is copied to data. Returns its length,
+// or -1 if the firmware did not take the request (LUFA would stall it).
+//
+// The OUT/IN calls and this one may come from other threads than the one
+// running the firmware; the selected endpoint is per thread, as the AVR's
+// is saved and restored around interrupts.
+int Standin_Control(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue,
+                    uint16_t wIndex, void *data, uint16_t length);
+
+// Deliver one byte to USART1 as if it had just been received.
+void Standin_UartRx(uint8_t data);
+
+// Take the next byte USART1 transmits, if its data-register-empty interrupt
+// has one to send.
+bool Standin_UartTx(uint8_t *data);
+
+#endif
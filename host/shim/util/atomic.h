@@ -0,0 +1,4 @@
+#pragma once
+#define ATOMIC_FORCEON 0
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(t) for (int _a = 1; _a; _a = 0)
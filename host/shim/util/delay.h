@@ -0,0 +1,3 @@
+#pragma once
+void _delay_ms(double ms);
+void _delay_us(double us);
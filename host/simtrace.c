@@ -0,0 +1,125 @@
+/*
+ * sim-PROGRAM - run a program on the stand-in and print the reports it sends.
+ *
+ *   make sim-toSS
+ *   ./sim-toSS [-t ms] > toSS.trace
+ *   ./sim-toSS -s [-t ms]             one summary line instead
+ *   ./sim-toSS -m [-t ms]             the trace with state marks, for tracestat
+ *   ./sim-toSS -a [-t ms]             every report, not only the changes
+ *
+ * The program runs as on the board, on the virtual clock, so minutes of it
+ * take a moment. One trace line per report that differs from the one before
+ * (every report with -a, as pcaptrace -a), as hidread prints them:
+ *   <time_us> <button hex> <hat> <lx> <ly> <rx> <ry>
+ * Stops after -t ms of virtual time (default 60000). With -m, programs that
+ * call Telemetry_Mark() also get comment lines, which other readers of
+ * traces skip:
+ *   # program <name>
+ *   # state <time_us> <state>
+ *
+ * The summary, which -a leaves alone, is what scripts/bench.sh compares against its golden values:
+ *   <reports> <changes> <last_ms> <report_us> <loop_us> <hash>
+ * reports sent, trace lines, time of the last change, mean time between
+ * reports, mean time per program loop, and an FNV-1a hash of the trace.
+ * A program loop runs from one entry of the loop-start state to the next:
+ * of the Telemetry_Mark() states entered more than once, the one entered
+ * first. loop_us is 0 for programs that mark no state or never loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Joystick.h"
+#include "idle.h"
+#include "standin.h"
+#include "telemetry.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+static uint64_t hash(uint64_t value, const char *line) {
+    while (*line)
+        value = (value ^ (uint8_t) *line++) * FNV_PRIME;
+    return value;
+}
+
+int main(int argc, char **argv) {
+    USB_JoystickReport_Input_t report, last;
+    unsigned long duration = 60000, reports = 0, changes = 0, last_ms = 0, loop_us = 0;
+    // Per state: first and latest entry time (ms) and number of entries,
+    // and the states in the order they were first entered.
+    unsigned long first_ms[256], latest_ms[256], entries[256] = {0};
+    uint8_t order[256];
+    int states = 0;
+    uint64_t trace_hash = FNV_OFFSET;
+    bool any = false, summary = false, marks = false, all = false;
+    uint8_t state = TELEMETRY_NO_STATE;
+    char line[64];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "amst:")) != -1) {
+        switch (opt) {
+            case 'a': all = true; break;
+            case 'm': marks = true; break;
+            case 's': summary = true; break;
+            case 't': duration = strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "usage: %s [-a] [-m | -s] [-t ms]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    SetupHardware();
+    GlobalInterruptEnable();
+    // The program's own main loop, with the IN endpoint emptied as a host polling it would.
+    marks = marks && !summary;
+    if (marks)
+        printf("# program %s\n", PROGRAM_NAME);
+    while (Standin_Millis() < duration) {
+        HID_Task();
+        USB_USBTask();
+        if (telemetry.state != state) {
+            state = telemetry.state;
+            if (!entries[state]++) {
+                first_ms[state] = Standin_Millis();
+                order[states++] = state;
+            }
+            latest_ms[state] = Standin_Millis();
+            if (marks)
+                printf("# state %lu %u\n", (unsigned long) Standin_Millis() * 1000, state);
+        }
+        if (Standin_In(&report, sizeof(report))) {
+            bool changed = !any || memcmp(&report, &last, sizeof(report));
+
+            reports++;
+            if (changed || all)
+                snprintf(line, sizeof(line), "%lu %04x %u %u %u %u %u\n", (unsigned long) Standin_Millis() * 1000,
+                         report.Button, report.HAT, report.LX, report.LY, report.RX, report.RY);
+            if (!summary && (changed || all))
+                fputs(line, stdout);
+            if (changed) {
+                trace_hash = hash(trace_hash, line);
+                last_ms = Standin_Millis();
+                changes++;
+                last = report;
+                any = true;
+            }
+        }
+        Idle_Sleep();
+    }
+    if (summary) {
+        for (int i = 0; i < states; i++) {
+            uint8_t s = order[i];
+
+            if (s != TELEMETRY_NO_STATE && entries[s] > 1) {
+                loop_us = (latest_ms[s] - first_ms[s]) * 1000 / (entries[s] - 1);
+                break;
+            }
+        }
+        printf("%lu %lu %lu %lu %lu %016llx\n", reports, changes, last_ms, reports ? duration * 1000 / reports : 0,
+               loop_us, (unsigned long long) trace_hash);
+    }
+    return 0;
+}
@@ -0,0 +1,502 @@
+/*
+ * slack - find how short a program's waits can be, from recorded runs.
+ *
+ *   slack init [-r ms] [-h ms] [-n loops] program.c table... > state
+ *   slack table [-f] [-m percent] [-p] state
+ *   slack run state trace results
+ *
+ * init starts a search over the wait_time of every step in the named
+ * BUTTON_MAP_t tables (in loop order, the first one starting each loop), e.g.
+ *   slack init ../toSS.c buy eatPre > toSS.slack
+ * Each wait is known to work at its current value. One step at a time is
+ * bisected downwards to -r ms (default 50), with every other step at the
+ * shortest value known to work.
+ *
+ * table prints the tables to build and flash for the next run: the step under
+ * test at its candidate value. With -f it prints the result instead, every
+ * step at its shortest known-good wait plus -m percent (default 10). With -p
+ * it prints the whole program with those tables, ready to build.
+ *
+ * run folds one run in: the trace of it (hidread, or a sim-PROGRAM) and a
+ * results file with one word per loop, pass or fail (1/0, ok/ng work too).
+ * It prints the measured wait of every step per loop and checks that the run
+ * was made with the current candidate. Any failed loop means the candidate is
+ * too short; -n passing loops (default 3) and no failure mean it works. The
+ * state is then rewritten with the next candidate.
+ *
+ * Steps are found in the trace by their reports: each press is a change away
+ * from neutral, and a step's wait is the time to the next press minus the
+ * hold time (-h, default 50 ms as in the programs). action.h is read from
+ * the program's directory, and action.c turns the names into reports.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "action.h"
+}
+
+namespace {
+
+// Measured waits within this of the candidate count as made with it.
+const long TOLERANCE_MS = 25;
+
+struct Step {
+    std::string action;
+    long wait;         // in the program source
+    bool until_ready;  // UNTIL_READY(wait)
+    size_t line;       // in the program source
+    long lo = -1;      // longest wait seen to fail
+    long hi = 0;       // shortest wait seen to work
+};
+
+struct Table {
+    std::string name;
+    size_t begin, end; // source lines, the declaration to the closing brace
+    std::vector<Step> steps;
+};
+
+struct State {
+    std::string program;
+    long resolution = 50, hold = 50, min_pass = 3;
+    std::vector<Table> tables;
+    std::vector<std::string> source;
+    // The step under test and its candidate wait; table < 0 once converged.
+    int table = -1, step = -1;
+    long candidate = 0;
+};
+
+struct Press {
+    uint64_t time_us;
+    USB_JoystickReport_Input_t report;
+};
+
+[[noreturn]] void Usage(const char *name) {
+    std::cerr << "usage: " << name << " init [-r ms] [-h ms] [-n loops] program.c table... > state\n"
+              << "       " << name << " table [-f] [-m percent] [-p] state\n"
+              << "       " << name << " run state trace results\n";
+    exit(2);
+}
+
+[[noreturn]] void Fail(const std::string &message) {
+    std::cerr << message << "\n";
+    exit(1);
+}
+
+std::vector<std::string> ReadLines(const std::string &path) {
+    std::ifstream in(path);
+    std::vector<std::string> lines;
+    std::string line;
+
+    if (!in)
+        Fail(path + ": cannot open");
+    while (std::getline(in, line))
+        lines.push_back(line);
+    return lines;
+}
+
+const std::regex ENTRY(R"(^(\s*\{\s*)([A-Z_]+)(\s*,\s*)(UNTIL_READY\()?(\d+)(\)?\s*\}.*)$)");
+
+// Reads the named tables from the program source, in the given order.
+void LoadTables(State &state, const std::vector<std::string> &names) {
+    state.source = ReadLines(state.program);
+    state.tables.clear();
+    for (const std::string &name : names) {
+        const std::regex declaration("^\\s*(const\\s+)?BUTTON_MAP_t\\s+" + name + "\\s*\\[\\s*\\]\\s*=\\s*\\{");
+        Table table{name, 0, 0, {}};
+        size_t i = 0;
+
+        while (i < state.source.size() && !std::regex_search(state.source[i], declaration))
+            i++;
+        if (i == state.source.size())
+            Fail(state.program + ": no BUTTON_MAP_t " + name + "[]");
+        table.begin = i;
+        for (i++; i < state.source.size() && state.source[i].find("};") == std::string::npos; i++) {
+            std::smatch m;
+            if (std::regex_match(state.source[i], m, ENTRY))
+                table.steps.push_back({m[2], std::stol(m[5]), m[4].matched, i});
+        }
+        table.end = i;
+        if (table.steps.empty())
+            Fail(state.program + ": " + name + "[] has no steps");
+        state.tables.push_back(table);
+    }
+}
+
+// ACTION_t values by name, from the action.h next to the program.
+std::map<std::string, ACTION_t> LoadActions(const std::string &program) {
+    size_t slash = program.rfind('/');
+    std::string path = (slash == std::string::npos ? std::string() : program.substr(0, slash + 1)) + "action.h";
+    const std::regex value(R"(^\s*([A-Z_]+)\s*=\s*(0x[0-9A-Fa-f]+|\d+)\s*,)");
+    std::map<std::string, ACTION_t> actions;
+    std::smatch m;
+
+    for (const std::string &line : ReadLines(path))
+        if (std::regex_search(line, m, value))
+            actions[m[1]] = (ACTION_t) std::stoul(m[2], nullptr, 0);
+    return actions;
+}
+
+USB_JoystickReport_Input_t Report(ACTION_t action) {
+    USB_JoystickReport_Input_t report;
+
+    memset(&report, 0, sizeof(report));
+    setButton(&report, BUTTON_RESET);
+    setButton(&report, action);
+    return report;
+}
+
+bool Same(const USB_JoystickReport_Input_t &a, const USB_JoystickReport_Input_t &b) {
+    return !memcmp(&a, &b, sizeof(a));
+}
+
+std::vector<Press> LoadPresses(const std::string &path) {
+    const USB_JoystickReport_Input_t neutral = Report(BUTTON_RESET);
+    USB_JoystickReport_Input_t last = neutral;
+    std::vector<Press> presses;
+
+    for (std::string line : ReadLines(path)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        unsigned long long time_us;
+        unsigned button, hat, lx, ly, rx, ry;
+        if (!(fields >> time_us >> std::hex >> button >> std::dec >> hat >> lx >> ly >> rx >> ry))
+            continue;
+        USB_JoystickReport_Input_t report;
+        memset(&report, 0, sizeof(report));
+        report.Button = button;
+        report.HAT = hat;
+        report.LX = lx;
+        report.LY = ly;
+        report.RX = rx;
+        report.RY = ry;
+        // Any change while not neutral is a step of its own too (chords, stick moves).
+        if (!Same(report, neutral) && !Same(report, last))
+            presses.push_back({time_us, report});
+        last = report;
+    }
+    return presses;
+}
+
+long Candidate(const State &state, long lo, long hi) {
+    long candidate = (lo + hi) / 2 / state.resolution * state.resolution;
+    return candidate > lo ? candidate : hi - state.resolution;
+}
+
+// Picks the first step whose search is not done yet.
+void NextCandidate(State &state) {
+    state.table = state.step = -1;
+    for (size_t t = 0; t < state.tables.size(); t++) {
+        for (size_t s = 0; s < state.tables[t].steps.size(); s++) {
+            const Step &step = state.tables[t].steps[s];
+            if (step.hi - step.lo > state.resolution) {
+                state.table = t;
+                state.step = s;
+                state.candidate = Candidate(state, step.lo, step.hi);
+                return;
+            }
+        }
+    }
+}
+
+// The wait a step has in the run being made.
+long Expected(const State &state, size_t t, size_t s) {
+    return (int) t == state.table && (int) s == state.step ? state.candidate : state.tables[t].steps[s].hi;
+}
+
+void Save(const State &state, const std::string &path) {
+    std::ofstream out(path);
+
+    out << "program " << state.program << "\n"
+        << "resolution " << state.resolution << "\nhold " << state.hold << "\nmin_pass " << state.min_pass << "\n";
+    if (state.table >= 0)
+        out << "testing " << state.tables[state.table].name << " " << state.step << " " << state.candidate << "\n";
+    for (const Table &table : state.tables)
+        for (size_t s = 0; s < table.steps.size(); s++)
+            out << "step " << table.name << " " << s << " " << table.steps[s].action << " " << table.steps[s].lo
+                << " " << table.steps[s].hi << "\n";
+    if (!out)
+        Fail(path + ": cannot write");
+}
+
+State Load(const std::string &path) {
+    State state;
+    std::vector<std::string> names;
+    std::vector<std::vector<std::pair<long, long>>> bounds;
+    std::string testing;
+    int testing_step = -1;
+
+    for (const std::string &line : ReadLines(path)) {
+        std::istringstream fields(line);
+        std::string word, name, action;
+        long index, lo, hi;
+        if (!(fields >> word))
+            continue;
+        if (word == "program")
+            fields >> state.program;
+        else if (word == "resolution")
+            fields >> state.resolution;
+        else if (word == "hold")
+            fields >> state.hold;
+        else if (word == "min_pass")
+            fields >> state.min_pass;
+        else if (word == "testing")
+            fields >> testing >> testing_step >> state.candidate;
+        else if (word == "step" && fields >> name >> index >> action >> lo >> hi) {
+            if (names.empty() || names.back() != name) {
+                names.push_back(name);
+                bounds.emplace_back();
+            }
+            bounds.back().push_back({lo, hi});
+        }
+    }
+    if (state.program.empty() || names.empty())
+        Fail(path + ": not a slack state file");
+
+    LoadTables(state, names);
+    for (size_t t = 0; t < names.size(); t++) {
+        if (bounds[t].size() != state.tables[t].steps.size())
+            Fail(state.program + ": " + names[t] + "[] no longer has the steps " + path + " was made for");
+        for (size_t s = 0; s < bounds[t].size(); s++) {
+            state.tables[t].steps[s].lo = bounds[t][s].first;
+            state.tables[t].steps[s].hi = bounds[t][s].second;
+        }
+        if (names[t] == testing) {
+            state.table = t;
+            state.step = testing_step;
+        }
+    }
+    return state;
+}
+
+// The tables with the waits to use, or with -p the whole program around them.
+void PrintTables(const State &state, bool final, long margin, bool program) {
+    std::map<size_t, std::pair<size_t, size_t>> entries; // source line to table, step
+
+    for (size_t t = 0; t < state.tables.size(); t++)
+        for (size_t s = 0; s < state.tables[t].steps.size(); s++)
+            entries[state.tables[t].steps[s].line] = {t, s};
+    for (size_t i = 0; i < state.source.size(); i++) {
+        bool inside = false;
+        for (const Table &table : state.tables)
+            inside |= i >= table.begin && i <= table.end;
+        if (!inside && !program)
+            continue;
+        std::smatch m;
+        if (entries.count(i) && std::regex_match(state.source[i], m, ENTRY)) {
+            auto [t, s] = entries[i];
+            long wait = Expected(state, t, s);
+            if (final)
+                wait = (state.tables[t].steps[s].hi * (100 + margin) + 99) / 100;
+            std::cout << m[1] << m[2] << m[3] << m[4] << wait << m[6] << "\n";
+        } else {
+            std::cout << state.source[i] << "\n";
+        }
+        if (!program && std::any_of(state.tables.begin(), state.tables.end(),
+                                    [i](const Table &table) { return i == table.end; }))
+            std::cout << "\n";
+    }
+}
+
+int Init(int argc, char **argv) {
+    State state;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:h:n:")) != -1) {
+        switch (opt) {
+            case 'r': state.resolution = std::max(1, atoi(optarg)); break;
+            case 'h': state.hold = atoi(optarg); break;
+            case 'n': state.min_pass = std::max(1, atoi(optarg)); break;
+            default: Usage(argv[0]);
+        }
+    }
+    if (argc - optind < 2)
+        Usage(argv[0]);
+    state.program = argv[optind];
+    LoadTables(state, std::vector<std::string>(argv + optind + 1, argv + argc));
+    for (Table &table : state.tables)
+        for (Step &step : table.steps)
+            step.hi = step.wait;
+    NextCandidate(state);
+    Save(state, "/dev/stdout");
+    return 0;
+}
+
+int PrintTable(int argc, char **argv) {
+    bool final = false, program = false;
+    long margin = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "fm:p")) != -1) {
+        switch (opt) {
+            case 'f': final = true; break;
+            case 'p': program = true; break;
+            case 'm': margin = atoi(optarg); break;
+            default: Usage(argv[0]);
+        }
+    }
+    if (argc - optind != 1)
+        Usage(argv[0]);
+    State state = Load(argv[optind]);
+    if (!final && state.table < 0)
+        std::cerr << "search done, printing the shortest waits that worked (-f adds a margin)\n";
+    PrintTables(state, final, margin, program);
+    return 0;
+}
+
+int Run(int argc, char **argv) {
+    if (argc != 5)
+        Usage(argv[0]);
+    const std::string path = argv[2];
+    State state = Load(path);
+    std::map<std::string, ACTION_t> actions = LoadActions(state.program);
+    std::vector<Press> presses = LoadPresses(argv[3]);
+    std::vector<bool> results;
+
+    for (const std::string &line : ReadLines(argv[4])) {
+        std::istringstream fields(line);
+        std::string word;
+        while (fields >> word) {
+            if (word == "pass" || word == "1" || word == "ok")
+                results.push_back(true);
+            else if (word == "fail" || word == "0" || word == "ng")
+                results.push_back(false);
+            else
+                Fail(std::string(argv[4]) + ": expected pass or fail, got " + word);
+        }
+    }
+
+    // Where each table's reports appear in the trace, as a whole.
+    std::vector<std::vector<USB_JoystickReport_Input_t>> wanted;
+    for (const Table &table : state.tables) {
+        wanted.emplace_back();
+        for (const Step &step : table.steps) {
+            if (!actions.count(step.action))
+                Fail(state.program + ": unknown action " + step.action);
+            wanted.back().push_back(Report(actions[step.action]));
+        }
+    }
+    auto matches = [&](size_t t, size_t at) {
+        if (at + wanted[t].size() > presses.size())
+            return false;
+        for (size_t s = 0; s < wanted[t].size(); s++)
+            if (!Same(presses[at + s].report, wanted[t][s]))
+                return false;
+        return true;
+    };
+
+    // Loops start where the first table does; each later table is taken at its first match after that.
+    std::vector<std::vector<long>> starts; // per loop, per table: press index or -1
+    for (size_t at = 0; at < presses.size(); at++) {
+        if (matches(0, at)) {
+            starts.push_back(std::vector<long>(state.tables.size(), -1));
+            starts.back()[0] = at;
+            at += wanted[0].size() - 1;
+        } else if (!starts.empty()) {
+            for (size_t t = 1; t < state.tables.size(); t++) {
+                if (starts.back()[t] < 0 && matches(t, at)) {
+                    starts.back()[t] = at;
+                    at += wanted[t].size() - 1;
+                    break;
+                }
+            }
+        }
+    }
+    if (starts.empty())
+        Fail(std::string(argv[3]) + ": " + state.tables[0].name + "[] does not appear in the trace");
+    if (results.size() != starts.size())
+        std::cerr << "warning: " << starts.size() << " loops in the trace, " << results.size() << " results\n";
+    size_t loops = std::min(results.size(), starts.size());
+
+    // Measured waits, per step, per loop; -1 where a loop has no measurement.
+    bool made_with_candidate = true;
+    printf("%-8s %4s %-14s %7s %7s %7s %7s %7s\n", "table", "step", "action", "wait", "min", "mean", "max", "bounds");
+    for (size_t t = 0; t < state.tables.size(); t++) {
+        for (size_t s = 0; s < state.tables[t].steps.size(); s++) {
+            const Step &step = state.tables[t].steps[s];
+            long expected = Expected(state, t, s), min = 0, max = 0, sum = 0, count = 0;
+            for (size_t loop = 0; loop < loops; loop++) {
+                long at = starts[loop][t];
+                if (at < 0 || at + s + 1 >= presses.size())
+                    continue;
+                long wait = (long) ((presses[at + s + 1].time_us - presses[at + s].time_us) / 1000) - state.hold;
+                min = count ? std::min(min, wait) : wait;
+                max = count ? std::max(max, wait) : wait;
+                sum += wait;
+                count++;
+            }
+            if (!count) {
+                printf("%-8s %4zu %-14s %7ld %7s\n", state.tables[t].name.c_str(), s, step.action.c_str(), expected, "-");
+                continue;
+            }
+            printf("%-8s %4zu %-14s %7ld %7ld %7ld %7ld %3ld..%ld%s\n", state.tables[t].name.c_str(), s,
+                   step.action.c_str(), expected, min, sum / count, max, step.lo, step.hi,
+                   (int) t == state.table && (int) s == state.step ? " <" : "");
+            // An UNTIL_READY() wait may end early; it may not run long.
+            if (max > expected + TOLERANCE_MS || (!step.until_ready && min < expected - TOLERANCE_MS))
+                made_with_candidate = false;
+        }
+    }
+
+    size_t passed = std::count(results.begin(), results.begin() + loops, true);
+    double loop_ms = 0;
+    if (starts.size() > 1)
+        loop_ms = (presses[starts.back()[0]].time_us - presses[starts.front()[0]].time_us) / 1000.0 /
+                  (starts.size() - 1);
+    printf("%zu loops, %zu passed, %.0f ms per loop\n", loops, passed, loop_ms);
+
+    if (state.table < 0) {
+        printf("search done\n");
+        return 0;
+    }
+    if (!made_with_candidate)
+        Fail("the run was not made with the current candidate (slack table " + path + "); state unchanged");
+
+    Step &step = state.tables[state.table].steps[state.step];
+    if (passed < loops) {
+        step.lo = state.candidate;
+        printf("%s[%d] fails at %ld ms\n", state.tables[state.table].name.c_str(), state.step, state.candidate);
+    } else if ((long) passed >= state.min_pass) {
+        step.hi = state.candidate;
+        printf("%s[%d] works at %ld ms\n", state.tables[state.table].name.c_str(), state.step, state.candidate);
+    } else {
+        printf("need %ld passing loops, state unchanged\n", state.min_pass);
+        return 0;
+    }
+    NextCandidate(state);
+    Save(state, path);
+    if (state.table >= 0)
+        printf("next: %s[%d] at %ld ms\n", state.tables[state.table].name.c_str(), state.step, state.candidate);
+    else
+        printf("search done: slack table -f %s\n", path.c_str());
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2)
+        Usage(argv[0]);
+    std::string command = argv[1];
+    // getopt() then sees the subcommand as the program name.
+    argv[1] = argv[0];
+    if (command == "init")
+        return Init(argc - 1, argv + 1);
+    if (command == "table")
+        return PrintTable(argc - 1, argv + 1);
+    if (command == "run")
+        return Run(argc, argv);
+    Usage(argv[0]);
+}
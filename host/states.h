@@ -0,0 +1,49 @@
+#ifndef _STATES_H_
+#define _STATES_H_
+
+// State names of the programs, in the order of each one's State_t, for the
+// tools that print what a board reports.
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *const to_ss_states[] = {"SYNC_CONTROLLER", "BUYING", "EAT_PRE", "EATING", "RESYNC", NULL};
+static const char *const eat_meat_states[] = {"SYNC_CONTROLLER", "PREPARE", "BUYING", "CHANGE_BLADE",
+                                              "CHANGE_POS", "CHANGE_PRE", "CHANGING", "EAT_PRE", "EATING",
+                                              "CONFIRM_BLADE", "RESYNC", "DONE", NULL};
+static const char *const mission_states[] = {"SYNC_CONTROLLER", "PREPARE", "COLLECT", "MISSION_1", "MISSION_2",
+                                             "MISSION_3", "CHOOSE_BLADE", "START_MISSION", "WAITING", NULL};
+static const char *const mission_all_states[] = {"SYNC_CONTROLLER", "PREPARE", "CHOOSE_MISSION", "CHOOSE_PEOPLE",
+                                                 "CONFIRM_PEOPLE", "START_MISSION", "WAITING", NULL};
+static const char *const open_card_states[] = {"SYNC_CONTROLLER", "PREPARE", "OPEN_CARD", NULL};
+static const char *const open_point_states[] = {"SYNC_CONTROLLER", "SEND", "RUN", "PICK", NULL};
+
+static const struct {
+    const char *program; // TARGET in the makefile
+    const char *const *names;
+} program_states[] = {
+    {"toSS", to_ss_states},
+    {"eatMeat", eat_meat_states},
+    {"mission", mission_states},
+    {"missionAll", mission_all_states},
+    {"openCard", open_card_states},
+    {"openPoint", open_point_states},
+};
+
+// The state's name, or its number for programs without a table here.
+static inline const char *state_name(const char *program, unsigned state) {
+    static char number[12];
+    const char *const *names = NULL;
+    unsigned i;
+
+    for (i = 0; i < sizeof(program_states) / sizeof(program_states[0]); i++)
+        if (!strcmp(program, program_states[i].program))
+            names = program_states[i].names;
+    for (i = 0; names && names[i]; i++)
+        if (i == state)
+            return names[i];
+    snprintf(number, sizeof(number), "%u", state);
+    return number;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * statsctl - print or clear the throughput counters of a board (stats.h).
+ *
+ *   statsctl /dev/hidrawN       per state: entries, time, share, per hour
+ *   statsctl -r /dev/hidrawN    clear them, e.g. before trying a new sequence
+ *
+ * Needs a build with STATS (make with-stats) of a program that keeps
+ * counters (toSS, eatMeat), through Feature report STATS_REPORT_ID. The board saves them to EEPROM
+ * every ten minutes, so up to that much is lost when it is unplugged.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "stats.h"
+#include "states.h"
+
+static const char *program_name(uint8_t program) {
+    return program == PARAMS_TO_SS ? "toSS" : program == PARAMS_EAT_MEAT ? "eatMeat" : "";
+}
+
+static void print_time(uint32_t ms) {
+    printf(" %4lu:%02lu:%02lu", (unsigned long) (ms / 3600000), (unsigned long) (ms / 60000 % 60),
+           (unsigned long) (ms / 1000 % 60));
+}
+
+int main(int argc, char **argv) {
+    STATS_REPORT_t report;
+    unsigned long long total = 0;
+    bool reset = false;
+    int fd, opt, i;
+
+    while ((opt = getopt(argc, argv, "r")) != -1) {
+        switch (opt) {
+            case 'r': reset = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-r] /dev/hidrawN\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-r] /dev/hidrawN\n", argv[0]);
+        return 2;
+    }
+    fd = open(argv[optind], O_RDWR);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if (reset) {
+        uint8_t id = STATS_REPORT_ID;
+        if (ioctl(fd, HIDIOCSFEATURE(sizeof(id)), &id) < 0) {
+            perror("HIDIOCSFEATURE");
+            return 1;
+        }
+        return 0;
+    }
+
+    memset(&report, 0, sizeof(report));
+    report.report_id = STATS_REPORT_ID;
+    if (ioctl(fd, HIDIOCGFEATURE(sizeof(report)), &report) < 0) {
+        perror("HIDIOCGFEATURE (a with-stats build of a program that keeps counters?)");
+        return 1;
+    }
+    if (report.count > STATS_MAX_STATES)
+        report.count = STATS_MAX_STATES;
+    for (i = 0; i < report.count; i++)
+        total += report.states[i].ms;
+
+    printf("%-16s %10s %12s %6s %10s %8s\n", "state", "entries", "time", "share", "mean ms", "per hour");
+    for (i = 0; i < report.count; i++) {
+        const STATS_STATE_t *state = &report.states[i];
+        printf("%-16s %10lu", state_name(program_name(report.program), i), (unsigned long) state->entries);
+        print_time(state->ms);
+        printf(" %5.1f%% %10lu %8.1f\n", total ? 100.0 * state->ms / total : 0.0,
+               state->entries ? (unsigned long) (state->ms / state->entries) : 0UL,
+               total ? state->entries * 3600000.0 / total : 0.0);
+    }
+    printf("%-16s %10s", "total", "");
+    print_time(total);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,320 @@
+/*
+ * streamctl - play a macro script through the firmware's stream commands.
+ *
+ *   streamctl [-t] script              against the in-process stand-in
+ *   streamctl -d /dev/hidrawN script   against a board built with-stream
+ *   streamctl -s /dev/ttyX script      against a board built with-uart, or
+ *                                      uartdev; set the line speed first
+ *
+ * Script lines, '#' starts a comment:
+ *   frame BUTTON HAT LX LY RX RY MS   queue one report held for MS
+ *   start | stop | status
+ *   set ID VALUE                      save parameter ID (params.h)
+ *   wait MS                           let the device run
+ *   expect FIELD VALUE                compare against the last status, where
+ *                                     FIELD is one of seq, playing, queued,
+ *                                     free, played, underruns, errors,
+ *                                     dropped (serial only)
+ *
+ * Frames are sent in batches of up to as many as the buffer has room for, and
+ * every command is retried until the status echoes its sequence number.
+ * With -t the stand-in prints each report it sends as a trace line:
+ *   <time_us> <button hex> <hat> <lx> <ly> <rx> <ry>
+ * Exits non-zero if an expect line fails.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "Joystick.h"
+#include "params.h"
+#include "stream.h"
+#include "timer.h"
+#include "uart.h"
+#include "standin.h"
+
+#define FRAMES_PER_PACKET ((JOYSTICK_EPSIZE - STREAM_HEADER_SIZE) / sizeof(STREAM_FRAME_t))
+
+static int device = -1;
+static bool serial;
+static bool trace;
+static uint8_t seq;
+static STREAM_STATUS_t status;
+static uint16_t dropped;
+
+static STREAM_FRAME_t pending[FRAMES_PER_PACKET];
+static uint8_t pending_count;
+
+// The stand-in runs no program of its own: it stays neutral unless streaming.
+void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
+    memset(ReportData, 0, sizeof(*ReportData));
+    ReportData->HAT = HAT_CENTER;
+    ReportData->LX = ReportData->LY = ReportData->RX = ReportData->RY = STICK_CENTER;
+}
+
+// The stand-in has no board hardware to set up.
+void SetupHardware(void) {
+    Timer_Init();
+    USB_Init();
+    // Parameters are only taken for the running program; stand in for mission.
+    Params_Init(PARAMS_MISSION);
+}
+
+static void run(uint32_t ms) {
+    static USB_JoystickReport_Input_t last;
+    static bool any;
+    USB_JoystickReport_Input_t report;
+
+    if (device >= 0) {
+        struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+        nanosleep(&ts, NULL);
+        return;
+    }
+    while (ms--) {
+        HID_Task();
+        if (Standin_In(&report, sizeof(report)) && trace && (!any || memcmp(&report, &last, sizeof(report)))) {
+            printf("%lu %04x %u %u %u %u %u\n", (unsigned long) Standin_Millis() * 1000, report.Button,
+                   report.HAT, report.LX, report.LY, report.RX, report.RY);
+            last = report;
+            any = true;
+        }
+        Standin_Tick();
+    }
+}
+
+// Wait up to 100 ms for the UART_REPLY_t answering the last packet.
+static bool serial_reply(void) {
+    UART_REPLY_t reply;
+    uint8_t *p = (uint8_t *) &reply;
+    size_t got = 0;
+    struct pollfd pfd = {device, POLLIN, 0};
+
+    while (got < sizeof(reply)) {
+        if (poll(&pfd, 1, 100) <= 0 || read(device, p + got, 1) != 1)
+            return false;
+        // Skip anything before the start of a reply.
+        if (got || p[0] == UART_REPLY_MAGIC)
+            got++;
+    }
+    status = reply.status;
+    dropped = reply.dropped;
+    return true;
+}
+
+static void send_packet(const uint8_t *packet, uint8_t length) {
+    if (serial) {
+        if (write(device, packet, length) < 0) {
+            perror("write");
+            exit(1);
+        }
+        return;
+    }
+    if (device < 0) {
+        Standin_Out(packet, length);
+        return;
+    }
+    // hidraw wants the report number first; 0 as the descriptor has none.
+    uint8_t buffer[JOYSTICK_EPSIZE + 1] = {0};
+    memcpy(buffer + 1, packet, length);
+    if (write(device, buffer, sizeof(buffer)) < 0) {
+        perror("write");
+        exit(1);
+    }
+}
+
+// Deliver a packet and refresh `status` from the answer; false if none came.
+static bool transact(const uint8_t *packet, uint8_t length);
+
+static void read_status(void) {
+    if (serial) {
+        uint8_t packet[STREAM_HEADER_SIZE] = {STREAM_MAGIC, STREAM_CMD_STATUS, 0, 0};
+        int tries;
+        for (tries = 0; tries < 100; tries++)
+            if (transact(packet, sizeof(packet)))
+                return;
+        fprintf(stderr, "no reply on the serial line\n");
+        exit(1);
+    }
+    if (device < 0) {
+        Standin_Control(REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE, HID_REQ_GetReport,
+                        (HID_REPORT_ITEM_Feature + 1) << 8, 0, &status, sizeof(status));
+        return;
+    }
+    uint8_t buffer[sizeof(status) + 1] = {0};
+    if (ioctl(device, HIDIOCGFEATURE(sizeof(buffer)), buffer) < 0) {
+        perror("HIDIOCGFEATURE");
+        exit(1);
+    }
+    memcpy(&status, buffer + 1, sizeof(status));
+}
+
+static bool transact(const uint8_t *packet, uint8_t length) {
+    send_packet(packet, length);
+    if (serial)
+        return serial_reply();
+    run(1);
+    read_status();
+    return true;
+}
+
+// Send one command and wait for its sequence number to come back. A command
+// the device counted as an error is reported once, not retried.
+static void command(uint8_t cmd, const void *payload, uint8_t length) {
+    uint8_t packet[JOYSTICK_EPSIZE];
+    uint16_t errors;
+    int tries;
+
+    // `status` is always the answer to the previous packet, so it is fresh enough here.
+    errors = status.errors;
+    seq++;
+    packet[0] = STREAM_MAGIC;
+    packet[1] = cmd;
+    packet[2] = seq;
+    packet[3] = length;
+    memcpy(packet + STREAM_HEADER_SIZE, payload, length);
+
+    for (tries = 0; tries < 100; tries++) {
+        if (!transact(packet, STREAM_HEADER_SIZE + length))
+            continue;
+        if (status.seq == seq)
+            return;
+        if (status.errors != errors) {
+            fprintf(stderr, "command %u rejected\n", cmd);
+            return;
+        }
+        run(5);
+    }
+    fprintf(stderr, "command %u not acknowledged\n", cmd);
+    exit(1);
+}
+
+static void flush(void) {
+    uint8_t count;
+
+    // Send what fits and wait for room for the rest, rather than have an
+    // ENQUEUE rejected. Room only grows between answers, so the last one is
+    // a safe estimate.
+    while (pending_count) {
+        while (!status.free) {
+            if (!status.playing) {
+                fprintf(stderr, "buffer full while stopped; start playback before queueing more\n");
+                exit(1);
+            }
+            run(1);
+            read_status();
+        }
+        count = pending_count < status.free ? pending_count : status.free;
+        command(STREAM_CMD_ENQUEUE, pending, count * sizeof(STREAM_FRAME_t));
+        pending_count -= count;
+        memmove(pending, pending + count, pending_count * sizeof(STREAM_FRAME_t));
+    }
+}
+
+static long status_field(const char *field) {
+    if (!strcmp(field, "seq"))       return status.seq;
+    if (!strcmp(field, "playing"))   return status.playing;
+    if (!strcmp(field, "queued"))    return status.queued;
+    if (!strcmp(field, "free"))      return status.free;
+    if (!strcmp(field, "played"))    return status.played;
+    if (!strcmp(field, "underruns")) return status.underruns;
+    if (!strcmp(field, "errors"))    return status.errors;
+    if (!strcmp(field, "dropped"))   return dropped;
+    fprintf(stderr, "unknown status field %s\n", field);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    char line[256];
+    unsigned lineno = 0;
+    int failures = 0;
+    FILE *script;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:s:t")) != -1) {
+        switch (opt) {
+            case 'd': path = optarg; break;
+            case 's': path = optarg; serial = true; break;
+            case 't': trace = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-t] [-d /dev/hidrawN | -s /dev/ttyX] script\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind >= argc || !(script = fopen(argv[optind], "r"))) {
+        fprintf(stderr, "usage: %s [-t] [-d /dev/hidrawN | -s /dev/ttyX] script\n", argv[0]);
+        return 2;
+    }
+    if (path && (device = open(path, O_RDWR | O_NOCTTY)) < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if (serial) {
+        struct termios tio;
+        tcgetattr(device, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(device, TCSANOW, &tio);
+    }
+    if (device < 0) {
+        SetupHardware();
+        EVENT_USB_Device_ConfigurationChanged();
+    }
+    // Carry on from where the last sender left the sequence numbers.
+    read_status();
+    seq = status.seq;
+
+    while (fgets(line, sizeof(line), script)) {
+        char word[16], field[16];
+        unsigned button, hat, lx, ly, rx, ry, ms, id;
+        long value;
+
+        lineno++;
+        line[strcspn(line, "#\n")] = 0;
+        if (sscanf(line, "%15s", word) != 1)
+            continue;
+
+        if (!strcmp(word, "frame") &&
+            sscanf(line, "%*s %x %u %u %u %u %u %u", &button, &hat, &lx, &ly, &rx, &ry, &ms) == 7) {
+            pending[pending_count++] = (STREAM_FRAME_t) {button, hat, lx, ly, rx, ry, ms};
+            if (pending_count == FRAMES_PER_PACKET)
+                flush();
+            continue;
+        }
+        flush();
+        if (!strcmp(word, "start")) {
+            command(STREAM_CMD_START, NULL, 0);
+        } else if (!strcmp(word, "stop")) {
+            command(STREAM_CMD_STOP, NULL, 0);
+        } else if (!strcmp(word, "status")) {
+            read_status();
+            printf("# seq %u playing %u queued %u free %u played %u underruns %u errors %u dropped %u\n",
+                   status.seq, status.playing, status.queued, status.free, status.played, status.underruns,
+                   status.errors, dropped);
+        } else if (!strcmp(word, "set") && sscanf(line, "%*s %u %ld", &id, &value) == 2) {
+            uint8_t payload[3] = {id, value & 0xFF, value >> 8};
+            command(STREAM_CMD_SET, payload, sizeof(payload));
+        } else if (!strcmp(word, "wait") && sscanf(line, "%*s %u", &ms) == 1) {
+            run(ms);
+        } else if (!strcmp(word, "expect") && sscanf(line, "%*s %15s %ld", field, &value) == 2) {
+            read_status();
+            if (status_field(field) != value) {
+                fprintf(stderr, "line %u: expected %s %ld, got %ld\n", lineno, field, value, status_field(field));
+                failures++;
+            }
+        } else {
+            fprintf(stderr, "line %u: cannot parse: %s\n", lineno, line);
+            return 2;
+        }
+    }
+    flush();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,429 @@
+/*
+ * streamd - keep a board's stream buffer full from macro scripts or traces.
+ *
+ *   streamd -s /dev/ttyX [options] [file...]     board built with-uart, or uartdev
+ *   streamd -d /dev/hidrawN [options] [file...]  board built with-stream
+ *
+ * Files are played one after another; without any, paths are read from
+ * stdin one per line for as long as it stays open, so another process can
+ * feed it through a FIFO. A file is a trace if its first line starts with a
+ * number (<time_us> <button hex> <hat> <lx> <ly> <rx> <ry>, one line per
+ * change) and a streamctl script otherwise, of which the frame and wait
+ * lines are played.
+ *
+ * Frames go out in ENQUEUE packets of up to -b frames. Several packets may be
+ * in flight: no more frames than the last reported free slots, and over the
+ * serial line no more bytes than the board's receive ring. The board only
+ * takes ENQUEUEs in sequence, so a packet unanswered for -r ms is sent again
+ * with everything after it. Playback starts once the buffer is full (or the
+ * file is all queued) and is stopped when the buffer has drained.
+ *
+ * After each file, prints the sustained reports/sec, the shallowest and
+ * deepest buffer seen while feeding, and the underruns during playback (the
+ * poll that finds the buffer empty at the very end counts as one).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+extern "C" {
+#include "stream.h"
+#include "uart.h"
+}
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const size_t MAX_FRAMES_PER_PACKET = (JOYSTICK_EPSIZE - STREAM_HEADER_SIZE) / sizeof(STREAM_FRAME_t);
+
+// Bytes the board can hold unread on its serial side (UART_RX_SIZE in uart.c).
+const size_t SERIAL_WINDOW_BYTES = 64;
+
+double Since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// How packets reach the board and how its status comes back.
+class Transport {
+  public:
+    virtual ~Transport() = default;
+    virtual void Send(const std::vector<uint8_t> &packet) = 0;
+    // Waits up to timeout_ms for a fresher status; false if none came.
+    virtual bool Poll(STREAM_STATUS_t &status, int timeout_ms) = 0;
+    // Asks for a status without sending anything else, where that is needed.
+    virtual void Query(uint8_t seq) = 0;
+    // Limit on unanswered bytes, 0 for none.
+    virtual size_t WindowBytes() const = 0;
+};
+
+// USART1 via a serial port or pty: every packet is answered by a UART_REPLY_t.
+class SerialTransport : public Transport {
+  public:
+    explicit SerialTransport(const char *path) {
+        fd_ = open(path, O_RDWR | O_NOCTTY);
+        if (fd_ < 0) {
+            perror(path);
+            exit(1);
+        }
+        termios tio;
+        tcgetattr(fd_, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(fd_, TCSANOW, &tio);
+    }
+    ~SerialTransport() override { close(fd_); }
+
+    void Send(const std::vector<uint8_t> &packet) override {
+        if (write(fd_, packet.data(), packet.size()) != (ssize_t) packet.size()) {
+            perror("write");
+            exit(1);
+        }
+    }
+
+    bool Poll(STREAM_STATUS_t &status, int timeout_ms) override {
+        pollfd pfd = {fd_, POLLIN, 0};
+        bool fresh = false;
+        uint8_t byte;
+
+        // Take every reply already waiting, then wait for one if there was none.
+        while (poll(&pfd, 1, fresh ? 0 : timeout_ms) > 0 && read(fd_, &byte, 1) == 1) {
+            if (reply_bytes_.empty() && byte != UART_REPLY_MAGIC)
+                continue;
+            reply_bytes_.push_back(byte);
+            if (reply_bytes_.size() == sizeof(UART_REPLY_t)) {
+                UART_REPLY_t reply;
+                memcpy(&reply, reply_bytes_.data(), sizeof(reply));
+                reply_bytes_.clear();
+                status = reply.status;
+                fresh = true;
+            }
+        }
+        return fresh;
+    }
+
+    // Replies only come for packets, so poke the board with a STATUS.
+    void Query(uint8_t seq) override { Send({STREAM_MAGIC, STREAM_CMD_STATUS, seq, 0}); }
+
+    size_t WindowBytes() const override { return SERIAL_WINDOW_BYTES; }
+
+  private:
+    int fd_;
+    std::vector<uint8_t> reply_bytes_;
+};
+
+// The OUT endpoint via hidraw, with the status read as a Feature report.
+class HidrawTransport : public Transport {
+  public:
+    explicit HidrawTransport(const char *path) {
+        fd_ = open(path, O_RDWR);
+        if (fd_ < 0) {
+            perror(path);
+            exit(1);
+        }
+    }
+    ~HidrawTransport() override { close(fd_); }
+
+    void Send(const std::vector<uint8_t> &packet) override {
+        // Report number 0 first, as the descriptor has none.
+        uint8_t buffer[JOYSTICK_EPSIZE + 1] = {0};
+        memcpy(buffer + 1, packet.data(), packet.size());
+        if (write(fd_, buffer, sizeof(buffer)) < 0) {
+            perror("write");
+            exit(1);
+        }
+    }
+
+    bool Poll(STREAM_STATUS_t &status, int timeout_ms) override {
+        uint8_t buffer[sizeof(STREAM_STATUS_t) + 1] = {0};
+        usleep(std::min(timeout_ms, 1) * 1000);
+        if (ioctl(fd_, HIDIOCGFEATURE(sizeof(buffer)), buffer) < 0) {
+            perror("HIDIOCGFEATURE");
+            exit(1);
+        }
+        memcpy(&status, buffer + 1, sizeof(status));
+        return true;
+    }
+
+    // Every Poll() reads the Feature report anyway.
+    void Query(uint8_t) override {}
+
+    size_t WindowBytes() const override { return 0; }
+
+  private:
+    int fd_;
+};
+
+bool ParseTrace(std::istream &in, std::vector<STREAM_FRAME_t> &frames) {
+    std::string line;
+    bool have = false;
+    unsigned long long time_us, last_us = 0;
+    STREAM_FRAME_t last = {};
+
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        unsigned button, hat, lx, ly, rx, ry;
+        if (!(fields >> time_us >> std::hex >> button >> std::dec >> hat >> lx >> ly >> rx >> ry))
+            continue;
+        if (have) {
+            // Whole ms on the board; round each edge so durations do not drift.
+            uint64_t ms = (time_us + 500) / 1000 - (last_us + 500) / 1000;
+            for (; ms > 0xFFFF; ms -= 0xFFFF) {
+                last.duration = 0xFFFF;
+                frames.push_back(last);
+            }
+            last.duration = ms;
+            if (ms)
+                frames.push_back(last);
+        }
+        last = {(uint16_t) button, (uint8_t) hat, (uint8_t) lx, (uint8_t) ly, (uint8_t) rx, (uint8_t) ry, 0};
+        last_us = time_us;
+        have = true;
+    }
+    // The final line has nothing after it to give it a length; traces end neutral anyway.
+    return have;
+}
+
+bool ParseScript(std::istream &in, std::vector<STREAM_FRAME_t> &frames) {
+    std::string line, word;
+
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        unsigned button, hat, lx, ly, rx, ry, ms;
+        if (!(fields >> word))
+            continue;
+        if (word == "frame" && fields >> std::hex >> button >> std::dec >> hat >> lx >> ly >> rx >> ry >> ms)
+            frames.push_back({(uint16_t) button, (uint8_t) hat, (uint8_t) lx, (uint8_t) ly, (uint8_t) rx,
+                              (uint8_t) ry, (uint16_t) ms});
+        else if (word == "wait" && fields >> ms)
+            frames.push_back({0, HAT_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, STICK_CENTER, (uint16_t) ms});
+    }
+    return true;
+}
+
+bool Load(const std::string &path, std::vector<STREAM_FRAME_t> &frames) {
+    std::ifstream in(path);
+    std::string first;
+
+    if (!in) {
+        std::cerr << path << ": cannot open\n";
+        return false;
+    }
+    while (std::getline(in, first) && first.find_first_not_of(" \t") != std::string::npos &&
+           first[first.find_first_not_of(" \t")] == '#');
+    bool trace = !first.empty() && isdigit((unsigned char) first[first.find_first_not_of(" \t")]);
+    in.clear();
+    in.seekg(0);
+    return trace ? ParseTrace(in, frames) : ParseScript(in, frames);
+}
+
+struct InFlight {
+    uint8_t seq;
+    size_t first;
+    size_t count;
+    std::vector<uint8_t> packet;
+    Clock::time_point sent;
+};
+
+class Streamer {
+  public:
+    Streamer(Transport &transport, size_t batch, int resend_ms)
+        : transport_(transport), batch_(batch), resend_ms_(resend_ms) {}
+
+    void Play(const std::string &name, const std::vector<STREAM_FRAME_t> &frames);
+
+  private:
+    std::vector<uint8_t> Packet(uint8_t cmd, const void *payload, size_t length) {
+        std::vector<uint8_t> packet = {STREAM_MAGIC, cmd, ++seq_, (uint8_t) length};
+        packet.insert(packet.end(), (const uint8_t *) payload, (const uint8_t *) payload + length);
+        return packet;
+    }
+
+    // Refreshes status_ and retires the packets it acknowledges.
+    bool Update(int timeout_ms) {
+        if (!transport_.Poll(status_, timeout_ms))
+            return false;
+        while (!in_flight_.empty() && (int8_t) (status_.seq - in_flight_.front().seq) >= 0)
+            in_flight_.pop_front();
+        return true;
+    }
+
+    // Sends a command once nothing is in flight, and waits until it is taken.
+    void Command(uint8_t cmd) {
+        while (!in_flight_.empty())
+            Wait();
+        std::vector<uint8_t> packet = Packet(cmd, nullptr, 0);
+        do {
+            transport_.Send(packet);
+        } while (!Update(resend_ms_) || status_.seq != seq_);
+    }
+
+    // Waits a little for news; asks for it if there is nothing to be answered,
+    // and resends if an answer is overdue.
+    void Wait() {
+        if (Update(1))
+            return;
+        if (in_flight_.empty()) {
+            transport_.Query(seq_);
+            return;
+        }
+        // Go back: resend the oldest unanswered packet and everything after it.
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - in_flight_.front().sent).count() >=
+            resend_ms_) {
+            resent_ += in_flight_.size();
+            for (InFlight &p : in_flight_) {
+                transport_.Send(p.packet);
+                p.sent = Clock::now();
+            }
+        }
+    }
+
+    size_t FramesInFlight() const {
+        size_t n = 0;
+        for (const InFlight &p : in_flight_)
+            n += p.count;
+        return n;
+    }
+
+    size_t BytesInFlight() const {
+        size_t n = 0;
+        for (const InFlight &p : in_flight_)
+            n += p.packet.size();
+        return n;
+    }
+
+    Transport &transport_;
+    size_t batch_;
+    int resend_ms_;
+    uint8_t seq_ = 0;
+    bool synced_ = false;
+    STREAM_STATUS_t status_ = {};
+    std::deque<InFlight> in_flight_;
+    unsigned long resent_ = 0;
+};
+
+void Streamer::Play(const std::string &name, const std::vector<STREAM_FRAME_t> &frames) {
+    size_t next = 0;
+    bool started = false;
+    Clock::time_point start;
+    uint16_t underruns = 0;
+    unsigned min_depth = 0, max_depth = 0, capacity;
+    uint64_t planned_ms = 0;
+
+    if (!synced_) {
+        // Carry on from whatever sequence number the board is at.
+        Command(STREAM_CMD_STOP);
+        seq_ = status_.seq;
+        synced_ = true;
+    }
+    capacity = status_.queued + status_.free;
+    for (const STREAM_FRAME_t &f : frames)
+        planned_ms += f.duration;
+
+    while (next < frames.size() || !in_flight_.empty()) {
+        size_t credit = status_.free > FramesInFlight() ? status_.free - FramesInFlight() : 0;
+        size_t count = std::min({credit, batch_, frames.size() - next});
+        size_t bytes = STREAM_HEADER_SIZE + count * sizeof(STREAM_FRAME_t);
+
+        if (count && (!transport_.WindowBytes() || BytesInFlight() + bytes <= transport_.WindowBytes())) {
+            InFlight p = {(uint8_t) (seq_ + 1), next, count,
+                          Packet(STREAM_CMD_ENQUEUE, &frames[next], count * sizeof(STREAM_FRAME_t)), Clock::now()};
+            transport_.Send(p.packet);
+            in_flight_.push_back(p);
+            next += count;
+            continue;
+        }
+        Wait();
+
+        if (!started && in_flight_.empty() && (next == frames.size() || !status_.free)) {
+            Command(STREAM_CMD_START);
+            started = true;
+            start = Clock::now();
+            underruns = status_.underruns;
+            min_depth = max_depth = status_.queued;
+        }
+        // Only while feeding; the buffer runs dry at the end by design.
+        if (started && next < frames.size()) {
+            min_depth = std::min<unsigned>(min_depth, status_.queued);
+            max_depth = std::max<unsigned>(max_depth, status_.queued);
+        }
+    }
+    if (!started) {
+        Command(STREAM_CMD_START);
+        start = Clock::now();
+        underruns = status_.underruns;
+        min_depth = max_depth = status_.queued;
+    }
+
+    // Let the buffer drain, then hand the board back to its program.
+    do
+        Wait();
+    while (status_.queued);
+    double seconds = Since(start);
+    underruns = status_.underruns - underruns;
+    Command(STREAM_CMD_STOP);
+
+    printf("%s: %zu frames, %.3f s (%.3f s planned), %.1f reports/s, depth %u..%u of %u, "
+           "%u underruns, %lu resent\n",
+           name.c_str(), frames.size(), seconds, planned_ms / 1000.0, frames.size() / seconds,
+           min_depth, max_depth, capacity, underruns, resent_);
+    fflush(stdout);
+    resent_ = 0;
+}
+
+void Usage(const char *argv0) {
+    fprintf(stderr, "usage: %s (-s /dev/ttyX | -d /dev/hidrawN) [-b frames] [-r ms] [file...]\n", argv0);
+    exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::unique_ptr<Transport> transport;
+    size_t batch = MAX_FRAMES_PER_PACKET;
+    int resend_ms = 50;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:b:r:")) != -1) {
+        switch (opt) {
+            case 's': transport.reset(new SerialTransport(optarg)); break;
+            case 'd': transport.reset(new HidrawTransport(optarg)); break;
+            case 'b': batch = std::clamp<size_t>(atoi(optarg), 1, MAX_FRAMES_PER_PACKET); break;
+            case 'r': resend_ms = std::max(1, atoi(optarg)); break;
+            default: Usage(argv[0]);
+        }
+    }
+    if (!transport)
+        Usage(argv[0]);
+
+    Streamer streamer(*transport, batch, resend_ms);
+    std::vector<std::string> paths(argv + optind, argv + argc);
+    std::string path;
+    size_t i = 0;
+
+    while (i < paths.size() ? (path = paths[i++], true) : (paths.empty() && std::getline(std::cin, path))) {
+        std::vector<STREAM_FRAME_t> frames;
+        if (path.empty() || !Load(path, frames))
+            continue;
+        streamer.Play(path, frames);
+    }
+    return 0;
+}
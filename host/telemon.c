@@ -0,0 +1,99 @@
+/*
+ * telemon - poll what a board is doing (telemetry.h), one line per interval.
+ *
+ *   telemon /dev/hidrawN               every second
+ *   telemon -i 200 -n 50 /dev/hidrawN  every 200 ms, 50 lines
+ *
+ * Needs a build with TELEMETRY (make with-telemetry), through Feature report
+ * TELEMETRY_REPORT_ID. Rates are the change since the previous line:
+ *   rep/s   IN reports sent; 200 when the Switch polls every 5 ms
+ *   busy/s  passes that found the IN bank still full (with-usb-isr: frames
+ *           where it was free and no report was ready)
+ *   late    ms delay() overran its waits by; growing means lost time
+ *   loop/s  main loop passes
+ * underrun and err are the stream counters of with-stream and with-uart
+ * builds; stack is the RAM the stack never reached, "-" off the board.
+ * resync is the anchors' escapes so far (resync.h), "/asked" those a lost
+ * program or a feedback timeout asked for, and "/h" their rate per hour.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/hidraw.h>
+
+#include "telemetry.h"
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-i ms] [-n lines] /dev/hidrawN\n", name);
+    exit(2);
+}
+
+static double rate(uint32_t now, uint32_t then, uint32_t ms) {
+    return ms ? (uint32_t) (now - then) * 1000.0 / ms : 0.0;
+}
+
+int main(int argc, char **argv) {
+    TELEMETRY_REPORT_t report, last;
+    unsigned interval = 1000;
+    long lines = -1;
+    bool first = true;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "i:n:")) != -1) {
+        switch (opt) {
+            case 'i': interval = strtoul(optarg, NULL, 0); break;
+            case 'n': lines = strtol(optarg, NULL, 0); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1 || !interval)
+        usage(argv[0]);
+    fd = open(argv[optind], O_RDWR);
+    if (fd < 0) {
+        perror(argv[optind]);
+        return 1;
+    }
+
+    printf("%-8s %5s %6s %10s %7s %7s %7s %7s %5s %8s %5s %5s %6s %6s %5s\n", "program", "state", "step", "uptime",
+           "rep/s", "busy/s", "late", "loop/s", "idle", "underrun", "err", "stack", "resync", "/asked", "/h");
+    while (lines--) {
+        uint32_t elapsed;
+
+        memset(&report, 0, sizeof(report));
+        report.report_id = TELEMETRY_REPORT_ID;
+        if (ioctl(fd, HIDIOCGFEATURE(sizeof(report)), &report) < 0) {
+            perror("HIDIOCGFEATURE (is this a with-telemetry build?)");
+            return 1;
+        }
+        if (first)
+            last = report;
+        elapsed = report.uptime_ms - last.uptime_ms;
+
+        printf("%-8.8s ", report.program);
+        if (report.state == TELEMETRY_NO_STATE)
+            printf("%5s %6s", "-", "-");
+        else
+            printf("%5u %6u", report.state, report.map_pos);
+        printf(" %4lu:%02lu:%02lu %7.1f %7.1f %7lu %7.0f %4.1f%% %8u %5u", (unsigned long) (report.uptime_ms / 3600000),
+               (unsigned long) (report.uptime_ms / 60000 % 60), (unsigned long) (report.uptime_ms / 1000 % 60),
+               rate(report.reports, last.reports, elapsed), rate(report.in_busy, last.in_busy, elapsed),
+               (unsigned long) (uint32_t) (report.late_ms - last.late_ms), rate(report.loops, last.loops, elapsed),
+               report.idle_permille / 10.0, report.stream_underruns, report.stream_errors);
+        if (report.free_stack == 0xFFFF)
+            printf(" %5s", "-");
+        else
+            printf(" %5u", report.free_stack);
+        printf(" %6u %6u %5u\n", report.resyncs, report.resync_requests, report.resyncs_per_hour);
+        fflush(stdout);
+
+        last = report;
+        first = false;
+        if (lines)
+            usleep(interval * 1000);
+    }
+    return 0;
+}
@@ -0,0 +1,362 @@
+/*
+ * tracestat - where a run spends its time, from its trace.
+ *
+ *   tracestat [-e end_us] [-n gaps] [-p program] [-v out.vcd] [-w us] trace
+ *
+ * Reads a trace from hidread, pcaptrace or sim-PROGRAM (- for stdin), one
+ * line per report or per change:
+ *   <time_us> <button hex> <hat> <lx> <ly> <rx> <ry>
+ * Each report lasts until the next line, the last one until -e (default: the
+ * last line's time). Prints:
+ *  - inputs per second: presses of a button, the HAT or a stick away from
+ *    neutral;
+ *  - the idle fraction, the share of time with a neutral report;
+ *  - the -n (default 5) longest neutral gaps;
+ *  - a histogram of the intervals between lines, in us: between reports for
+ *    a trace of every report (sim-PROGRAM -a, pcaptrace -a), in -w us bins
+ *    (default 100), so that poll jitter shows; otherwise between changes,
+ *    which is how long inputs and waits lasted, in powers of two unless -w;
+ *  - with the "# state" marks of sim-PROGRAM -m, time and entries per state,
+ *    named after the "# program" mark or -p.
+ * With -v, also writes every button, the HAT, the sticks and the state as a
+ * VCD waveform for GTKWave, in microseconds.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Joystick.h"
+#include "states.h"
+
+struct Report {
+    unsigned long long time;
+    unsigned button, hat, lx, ly, rx, ry;
+    int state; // -1 before the first mark
+};
+
+struct Mark {
+    unsigned long long time;
+    int state;
+};
+
+struct Trace {
+    std::string program;
+    std::vector<Report> reports;
+    std::vector<Mark> marks;
+    unsigned long long end = 0;
+};
+
+const char *const BUTTONS[] = {"Y", "B", "A", "X", "L", "R", "ZL", "ZR",
+                               "MINUS", "PLUS", "LCLICK", "RCLICK", "HOME", "CAPTURE"};
+const int BUTTON_COUNT = sizeof(BUTTONS) / sizeof(BUTTONS[0]);
+
+[[noreturn]] void Fail(const std::string &message) {
+    std::cerr << message << "\n";
+    exit(1);
+}
+
+[[noreturn]] void Usage(const char *name) {
+    std::cerr << "usage: " << name << " [-e end_us] [-n gaps] [-p program] [-v out.vcd] [-w us] trace\n";
+    exit(2);
+}
+
+bool Neutral(const Report &r) {
+    return !r.button && r.hat == HAT_CENTER && r.lx == STICK_CENTER && r.ly == STICK_CENTER &&
+           r.rx == STICK_CENTER && r.ry == STICK_CENTER;
+}
+
+bool StickMoved(unsigned from, unsigned to) {
+    return from == STICK_CENTER && to != STICK_CENTER;
+}
+
+// Something went down in `to` that was up in `from`.
+bool Pressed(const Report &from, const Report &to) {
+    return (to.button & ~from.button) || (from.hat == HAT_CENTER && to.hat != HAT_CENTER) ||
+           StickMoved(from.lx, to.lx) || StickMoved(from.ly, to.ly) || StickMoved(from.rx, to.rx) ||
+           StickMoved(from.ry, to.ry);
+}
+
+Trace Read(std::istream &in) {
+    Trace trace;
+    std::string line;
+    int state = -1;
+
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string word;
+        Report r;
+
+        if (!(fields >> word))
+            continue;
+        if (word == "#") {
+            unsigned long long time;
+            fields >> word;
+            if (word == "program")
+                fields >> trace.program;
+            else if (word == "state" && fields >> time >> state) {
+                trace.marks.push_back({time, state});
+                trace.end = std::max(trace.end, time);
+            }
+            continue;
+        }
+        fields.clear();
+        fields.seekg(0);
+        if (!(fields >> r.time >> std::hex >> r.button >> std::dec >> r.hat >> r.lx >> r.ly >> r.rx >> r.ry))
+            Fail("not a trace line: " + line);
+        r.state = state;
+        trace.reports.push_back(r);
+        trace.end = std::max(trace.end, r.time);
+    }
+    if (trace.reports.empty())
+        Fail("no reports in the trace");
+    return trace;
+}
+
+std::string Seconds(unsigned long long us) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.3f s", us / 1e6);
+    return text;
+}
+
+void PrintInputs(const Trace &trace) {
+    const std::vector<Report> &reports = trace.reports;
+    unsigned long long start = reports.front().time, span = trace.end - start, idle = 0;
+    unsigned long presses = 0;
+
+    for (size_t i = 0; i < reports.size(); i++) {
+        unsigned long long until = i + 1 < reports.size() ? reports[i + 1].time : trace.end;
+        if (Neutral(reports[i]))
+            idle += until - reports[i].time;
+        if (i && Pressed(reports[i - 1], reports[i]))
+            presses++;
+    }
+    if (!Neutral(reports.front()))
+        presses++;
+    printf("%zu lines over %s\n", reports.size(), Seconds(span).c_str());
+    printf("inputs: %lu, %.2f per second\n", presses, span ? presses * 1e6 / span : 0.0);
+    printf("idle: %.1f%% neutral\n", span ? 100.0 * idle / span : 0.0);
+}
+
+void PrintGaps(const Trace &trace, size_t count) {
+    struct Gap {
+        unsigned long long start, length;
+        int state;
+    };
+    const std::vector<Report> &reports = trace.reports;
+    std::vector<Gap> gaps;
+
+    for (size_t i = 0; i < reports.size(); i++) {
+        size_t j = i;
+        if (!Neutral(reports[i]))
+            continue;
+        while (j + 1 < reports.size() && Neutral(reports[j + 1]))
+            j++;
+        unsigned long long until = j + 1 < reports.size() ? reports[j + 1].time : trace.end;
+        gaps.push_back({reports[i].time, until - reports[i].time, reports[i].state});
+        i = j;
+    }
+    std::sort(gaps.begin(), gaps.end(), [](const Gap &a, const Gap &b) { return a.length > b.length; });
+    if (gaps.size() > count)
+        gaps.resize(count);
+
+    printf("\nlongest neutral gaps:\n");
+    for (const Gap &gap : gaps) {
+        printf("  %10.1f ms at %12s", gap.length / 1000.0, Seconds(gap.start).c_str());
+        if (gap.state >= 0)
+            printf("  in %s", state_name(trace.program.c_str(), gap.state));
+        printf("\n");
+    }
+}
+
+bool SameInputs(const Report &a, const Report &b) {
+    return a.button == b.button && a.hat == b.hat && a.lx == b.lx && a.ly == b.ly && a.rx == b.rx && a.ry == b.ry;
+}
+
+// A trace of every report (sim-PROGRAM -a, pcaptrace -a) repeats lines; one of
+// changes never does.
+bool EveryReport(const Trace &trace) {
+    const std::vector<Report> &reports = trace.reports;
+
+    for (size_t i = 1; i < reports.size(); i++)
+        if (SameInputs(reports[i - 1], reports[i]))
+            return true;
+    return false;
+}
+
+void PrintIntervals(const Trace &trace, unsigned long long width) {
+    const std::vector<Report> &reports = trace.reports;
+    const bool every = EveryReport(trace);
+    std::map<unsigned long long, unsigned long> buckets; // by the first us of the bucket
+    unsigned long most = 0;
+
+    // Polls want fine bins to show jitter; holds and waits span too much for them.
+    if (!width && every)
+        width = 100;
+    for (size_t i = 1; i < reports.size(); i++) {
+        unsigned long long us = reports[i].time - reports[i - 1].time, start = 0;
+        if (width)
+            start = us / width * width;
+        else
+            while (start * 2 <= us && us)
+                start = start ? start * 2 : 1;
+        most = std::max(most, ++buckets[start]);
+    }
+    if (buckets.empty())
+        return;
+
+    if (every)
+        printf("\nintervals between reports:\n");
+    else
+        printf("\nintervals between changes, i.e. how long each input or wait lasted (-a traces show polls):\n");
+    for (const auto &[start, count] : buckets) {
+        unsigned long long last = width ? start + width - 1 : start ? start * 2 - 1 : 0;
+        char range[48];
+        snprintf(range, sizeof(range), "%llu-%llu us", start, last);
+        printf("  %22s %8lu %s\n", range, count, std::string(count * 40 / most, '#').c_str());
+    }
+}
+
+void PrintStates(const Trace &trace) {
+    struct Time {
+        unsigned long entries = 0;
+        unsigned long long us = 0;
+    };
+    const std::vector<Mark> &marks = trace.marks;
+    std::map<int, Time> states;
+    unsigned long long total = 0;
+
+    for (size_t i = 0; i < marks.size(); i++) {
+        unsigned long long until = i + 1 < marks.size() ? marks[i + 1].time : trace.end;
+        Time &time = states[marks[i].state];
+        time.entries++;
+        time.us += until - marks[i].time;
+        total += until - marks[i].time;
+    }
+    if (states.empty())
+        return;
+
+    printf("\n%-16s %8s %14s %6s %12s\n", "state", "entries", "time", "share", "mean");
+    for (const auto &[state, time] : states)
+        printf("%-16s %8lu %14s %5.1f%% %9.1f ms\n", state_name(trace.program.c_str(), state), time.entries,
+               Seconds(time.us).c_str(), total ? 100.0 * time.us / total : 0.0,
+               time.us / 1000.0 / time.entries);
+}
+
+// Identifiers for the VCD: printable characters from '!'.
+std::string Id(int n) {
+    return std::string(1, static_cast<char>('!' + n));
+}
+
+std::string Binary(unsigned value, int bits) {
+    std::string text = "b";
+    for (int bit = bits - 1; bit >= 0; bit--)
+        text += value >> bit & 1 ? '1' : '0';
+    return text;
+}
+
+void WriteReport(std::ofstream &out, const Report &r, const Report *last) {
+    const unsigned values[] = {r.lx, r.ly, r.rx, r.ry};
+    const unsigned previous[] = {last ? last->lx : ~0u, last ? last->ly : ~0u, last ? last->rx : ~0u,
+                                 last ? last->ry : ~0u};
+
+    for (int i = 0; i < BUTTON_COUNT; i++)
+        if (!last || ((r.button ^ last->button) >> i & 1))
+            out << (r.button >> i & 1) << Id(i) << "\n";
+    if (!last || r.hat != last->hat)
+        out << Binary(r.hat, 4) << " " << Id(BUTTON_COUNT) << "\n";
+    for (int i = 0; i < 4; i++)
+        if (values[i] != previous[i])
+            out << Binary(values[i], 8) << " " << Id(BUTTON_COUNT + 1 + i) << "\n";
+}
+
+void WriteVcd(const Trace &trace, const std::string &path) {
+    const std::vector<Report> &reports = trace.reports;
+    const std::vector<Mark> &marks = trace.marks;
+    const int state = BUTTON_COUNT + 5;
+    const char *const stick_names[] = {"LX", "LY", "RX", "RY"};
+    const unsigned long long never = ~0ULL;
+    const Report *last = nullptr;
+    std::ofstream out(path);
+    size_t r = 0, m = 0;
+
+    if (!out)
+        Fail(path + ": cannot write");
+    out << "$timescale 1 us $end\n$scope module " << (trace.program.empty() ? "trace" : trace.program) << " $end\n";
+    for (int i = 0; i < BUTTON_COUNT; i++)
+        out << "$var wire 1 " << Id(i) << " " << BUTTONS[i] << " $end\n";
+    out << "$var wire 4 " << Id(BUTTON_COUNT) << " HAT $end\n";
+    for (int i = 0; i < 4; i++)
+        out << "$var wire 8 " << Id(BUTTON_COUNT + 1 + i) << " " << stick_names[i] << " $end\n";
+    if (!marks.empty())
+        out << "$var wire 8 " << Id(state) << " state $end\n";
+    out << "$upscope $end\n$enddefinitions $end\n";
+
+    // Reports and marks in time order, one timestamp for everything at the same time.
+    while (r < reports.size() || m < marks.size()) {
+        unsigned long long time = std::min(r < reports.size() ? reports[r].time : never,
+                                           m < marks.size() ? marks[m].time : never);
+        out << "#" << time << "\n";
+        if (!marks.empty() && !r && !m && marks[0].time > time)
+            out << "bx " << Id(state) << "\n";
+        for (; m < marks.size() && marks[m].time == time; m++)
+            out << Binary(marks[m].state, 8) << " " << Id(state) << "\n";
+        for (; r < reports.size() && reports[r].time == time; r++) {
+            WriteReport(out, reports[r], last);
+            last = &reports[r];
+        }
+    }
+    if (trace.end > (last ? last->time : 0) && (marks.empty() || trace.end > marks.back().time))
+        out << "#" << trace.end << "\n";
+}
+
+int main(int argc, char **argv) {
+    unsigned long long end = 0;
+    unsigned long long width = 0;
+    size_t gaps = 5;
+    std::string program, vcd;
+    Trace trace;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "e:n:p:v:w:")) != -1) {
+        switch (opt) {
+            case 'e': end = strtoull(optarg, nullptr, 0); break;
+            case 'n': gaps = strtoul(optarg, nullptr, 0); break;
+            case 'p': program = optarg; break;
+            case 'v': vcd = optarg; break;
+            case 'w': width = strtoull(optarg, nullptr, 0); break;
+            default: Usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1)
+        Usage(argv[0]);
+
+    if (std::string(argv[optind]) == "-") {
+        trace = Read(std::cin);
+    } else {
+        std::ifstream in(argv[optind]);
+        if (!in)
+            Fail(std::string(argv[optind]) + ": cannot open");
+        trace = Read(in);
+    }
+    if (!program.empty())
+        trace.program = program;
+    if (end)
+        trace.end = std::max(end, trace.reports.back().time);
+
+    PrintInputs(trace);
+    PrintGaps(trace, gaps);
+    PrintIntervals(trace, width);
+    PrintStates(trace);
+    if (!vcd.empty())
+        WriteVcd(trace, vcd);
+    return 0;
+}
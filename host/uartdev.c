@@ -0,0 +1,116 @@
+/*
+ * uartdev - the board in with-uart mode, on a pseudo terminal.
+ *
+ *   uartdev [-t]
+ *
+ * Prints the slave side of a new pty (e.g. /dev/pts/7) on its first line,
+ * then runs hid.c, stream.c and uart.c in real time: bytes written to the pty
+ * arrive on the stand-in's USART1 at no more than UART_BAUD, replies come
+ * back the same way, and the stand-in host polls the IN endpoint every ms.
+ * With -t every report that changes is printed as a trace line:
+ *   <time_us> <button hex> <hat> <lx> <ly> <rx> <ry>
+ * Point streamctl -s at the printed path. Runs until SIGINT/SIGTERM.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Joystick.h"
+#include "params.h"
+#include "timer.h"
+#include "uart.h"
+#include "standin.h"
+
+#define BYTES_PER_MS (UART_BAUD / 10 / 1000)
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int sig) {
+    (void) sig;
+    running = 0;
+}
+
+// Stays neutral unless streaming, like streamctl's stand-in.
+void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
+    memset(ReportData, 0, sizeof(*ReportData));
+    ReportData->HAT = HAT_CENTER;
+    ReportData->LX = ReportData->LY = ReportData->RX = ReportData->RY = STICK_CENTER;
+}
+
+void SetupHardware(void) {
+    Timer_Init();
+    USB_Init();
+    // Parameters are only taken for the running program; stand in for mission.
+    Params_Init(PARAMS_MISSION);
+}
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+}
+
+int main(int argc, char **argv) {
+    bool trace = argc > 1 && !strcmp(argv[1], "-t");
+    USB_JoystickReport_Input_t report, last;
+    bool any = false;
+    struct termios tio;
+    uint64_t start;
+    int master;
+
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master)) {
+        perror("pty");
+        return 1;
+    }
+    // Raw bytes both ways; the slave side inherits this.
+    tcgetattr(master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(master, TCSANOW, &tio);
+    fcntl(master, F_SETFL, O_NONBLOCK);
+    printf("%s\n", ptsname(master));
+    fflush(stdout);
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    SetupHardware();
+    EVENT_USB_Device_ConfigurationChanged();
+    start = now_ms();
+
+    while (running) {
+        uint8_t buffer[BYTES_PER_MS];
+        ssize_t n, i;
+
+        // Keep the virtual clock on the wall clock.
+        while (Standin_Millis() < now_ms() - start) {
+            n = read(master, buffer, sizeof(buffer));
+            for (i = 0; i < n; i++)
+                Standin_UartRx(buffer[i]);
+
+            HID_Task();
+            if (Standin_In(&report, sizeof(report)) && trace && (!any || memcmp(&report, &last, sizeof(report)))) {
+                printf("%lu %04x %u %u %u %u %u\n", (unsigned long) Standin_Millis() * 1000, report.Button,
+                       report.HAT, report.LX, report.LY, report.RX, report.RY);
+                fflush(stdout);
+                last = report;
+                any = true;
+            }
+
+            for (i = 0; i < BYTES_PER_MS && Standin_UartTx(&buffer[i]); i++);
+            if (i && write(master, buffer, i) < 0)
+                running = 0;
+            Standin_Tick();
+        }
+
+        nanosleep(&(struct timespec) {0, 500000}, NULL);
+    }
+    return 0;
+}
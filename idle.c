@@ -0,0 +1,30 @@
+#include "idle.h"
+#include "profile.h"
+#include "timer.h"
+
+IDLE_STATS_t idle_stats;
+
+static uint32_t window_start;
+static uint32_t window_idle; // cycles spent asleep in the current window
+
+void Idle_Sleep(void) {
+    uint32_t start = Timer_Cycles();
+    uint32_t elapsed, slept;
+
+    Timer_Sleep();
+    slept = Timer_Cycles() - start;
+    window_idle += slept;
+#ifdef PROFILE
+    profile_slept += slept;
+#endif
+    idle_stats.wakeups++;
+
+    if (!Timer_Reached(window_start + IDLE_WINDOW_MS))
+        return;
+    elapsed = millis() - window_start;
+    idle_stats.idle_permille = window_idle / (elapsed * (TIMER_CYCLES_PER_MS / 1000));
+    idle_stats.idle_ms += window_idle / TIMER_CYCLES_PER_MS;
+    idle_stats.busy_ms += elapsed - window_idle / TIMER_CYCLES_PER_MS;
+    window_start += elapsed;
+    window_idle = 0;
+}
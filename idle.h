@@ -0,0 +1,24 @@
+#ifndef _IDLE_H_
+#define _IDLE_H_
+
+#include <stdint.h>
+
+// Sleep accounting for the main loop. Idle_Sleep() puts the CPU in
+// SLEEP_MODE_IDLE until the next interrupt: the 1 ms Timer1 tick at the
+// latest, or any USB interrupt before it. With a 5 ms polling interval a free
+// IN bank is therefore refilled well before the host asks for it again.
+typedef struct {
+  uint32_t idle_ms;       // total time spent asleep
+  uint32_t busy_ms;       // total time spent awake
+  uint32_t wakeups;
+  uint16_t idle_permille; // share of the last window spent asleep
+} IDLE_STATS_t;
+
+#define IDLE_WINDOW_MS 1000
+
+extern IDLE_STATS_t idle_stats;
+
+// Call once per main-loop pass, after HID_Task() and USB_USBTask().
+void Idle_Sleep(void);
+
+#endif
@@ -0,0 +1,67 @@
+#include "menu.h"
+
+static uint32_t edge_cost(const MENU_EDGE_t *edge) {
+    uint32_t cost = 0;
+    uint8_t i;
+
+    for (i = 0; i < edge->count; i++)
+        cost += MENU_HOLD_MS + edge->steps[i].wait_time;
+    return cost;
+}
+
+bool Menu_Goto(MENU_t *menu, uint8_t screen) {
+    // One slot per screen, plus MENU_MAX_SCREENS standing for "unknown".
+    uint32_t cost[MENU_MAX_SCREENS + 1];
+    uint8_t via[MENU_MAX_SCREENS + 1], previous[MENU_MAX_SCREENS + 1];
+    uint8_t start = menu->screen < MENU_MAX_SCREENS ? menu->screen : MENU_MAX_SCREENS;
+    uint8_t pass, i, s, length;
+
+    menu->path_length = menu->path_pos = menu->step = 0;
+    if (screen >= MENU_MAX_SCREENS)
+        return false;
+    for (s = 0; s <= MENU_MAX_SCREENS; s++)
+        cost[s] = UINT32_MAX;
+    cost[start] = 0;
+
+    // Bellman-Ford; a handful of screens and edges, so no need for better.
+    for (pass = 0; pass < MENU_MAX_SCREENS; pass++) {
+        for (i = 0; i < menu->edge_count; i++) {
+            const MENU_EDGE_t *edge = &menu->edges[i];
+            uint32_t step = edge_cost(edge);
+            for (s = 0; s <= MENU_MAX_SCREENS; s++) {
+                if (cost[s] == UINT32_MAX || (edge->from != MENU_ANY && edge->from != s))
+                    continue;
+                if (cost[s] + step < cost[edge->to]) {
+                    cost[edge->to] = cost[s] + step;
+                    via[edge->to] = i;
+                    previous[edge->to] = s;
+                }
+            }
+        }
+    }
+    if (cost[screen] == UINT32_MAX)
+        return false;
+
+    for (length = 0, s = screen; s != start; s = previous[s])
+        length++;
+    if (length > MENU_MAX_PATH)
+        return false;
+    menu->path_length = length;
+    for (s = screen; s != start; s = previous[s])
+        menu->path[--length] = via[s];
+    return true;
+}
+
+const BUTTON_MAP_t *Menu_Next(MENU_t *menu) {
+    while (menu->path_pos < menu->path_length) {
+        const MENU_EDGE_t *edge = &menu->edges[menu->path[menu->path_pos]];
+        if (menu->step < edge->count)
+            return &edge->steps[menu->step++];
+        menu->screen = edge->to;
+        if (edge->cursor)
+            Grid_Reset(edge->cursor, 0);
+        menu->path_pos++;
+        menu->step = 0;
+    }
+    return NULL;
+}
@@ -0,0 +1,67 @@
+#ifndef _MENU_H_
+#define _MENU_H_
+
+#include "action.h"
+#include "grid.h"
+
+// Which screen of the game a program has left it on, so that it can go
+// straight from there to the next screen it needs instead of backing out to
+// the field with a row of B presses and walking back in every loop.
+//
+// Screens are small numbers chosen by the program. Each edge is a known way
+// from one screen to another; Menu_Goto() picks the cheapest chain of edges
+// (by hold plus wait time) and Menu_Next() hands out its steps. Steps a program
+// plays outside the model must leave the game on the same screen, or be
+// followed by Menu_Set() or Menu_Lost().
+#define MENU_MAX_SCREENS 8
+#define MENU_MAX_PATH    8
+#define MENU_UNKNOWN     0xFF // after power-up, or whenever the program is unsure
+#define MENU_ANY         0xFE // as an edge's `from`: works from every screen, even an unknown one
+
+// Hold time Menu_Goto() adds to each step's wait_time when costing an edge.
+#define MENU_HOLD_MS 50
+
+typedef struct {
+  uint8_t from;
+  uint8_t to;
+  const BUTTON_MAP_t *steps;
+  uint8_t count;
+  GRID_t *cursor; // cursor the game puts back on cell 0 when `to` is entered this way, or NULL
+} MENU_EDGE_t;
+
+// Shorthand for an edge playing a whole BUTTON_MAP_t table.
+#define MENU_EDGE(from, to, steps, cursor) \
+  {(from), (to), (steps), sizeof(steps) / sizeof(BUTTON_MAP_t), (cursor)}
+
+typedef struct {
+  const MENU_EDGE_t *edges;
+  uint8_t edge_count;
+  uint8_t screen;
+  uint8_t path[MENU_MAX_PATH]; // edge indices planned by Menu_Goto()
+  uint8_t path_length;
+  uint8_t path_pos;
+  uint8_t step;
+} MENU_t;
+
+// Static initializer, screen unknown.
+#define MENU(edges) {(edges), sizeof(edges) / sizeof(MENU_EDGE_t), MENU_UNKNOWN}
+
+static inline void Menu_Set(MENU_t *menu, uint8_t screen) {
+  menu->screen = screen;
+  menu->path_length = menu->path_pos = menu->step = 0;
+}
+
+static inline void Menu_Lost(MENU_t *menu) {
+  Menu_Set(menu, MENU_UNKNOWN);
+}
+
+// Plans the cheapest way to `screen`; nothing at all if the game is already
+// there. False, with nothing planned, if the edges don't lead there.
+bool Menu_Goto(MENU_t *menu, uint8_t screen);
+
+// Next step towards the planned screen, NULL once there. The screen (and the
+// edge's cursor) is updated when the step after an edge's last one is asked
+// for, i.e. once that step's wait is over.
+const BUTTON_MAP_t *Menu_Next(MENU_t *menu);
+
+#endif
@@ -26,6 +26,12 @@ these buttons for our use.
 
 #include "Joystick.h"
 #include "action.h"
+#include "grid.h"
+#include "idle.h"
+#include "menu.h"
+#include "params.h"
+#include "telemetry.h"
+#include "timer.h"
 #ifndef ALERT_WHEN_DONE
 #define ALERT_WHEN_DONE
 #endif
@@ -42,6 +48,8 @@ int main(void) {
     HID_Task();
     // We also need to run the main USB management task.
     USB_USBTask();
+    // Then doze until the next timer tick or USB interrupt.
+    Idle_Sleep();
   }
 }
 
@@ -65,82 +73,18 @@ PORTD will toggle when printing is done.
   DDRB = 0xFF; //uses PORTB. Micro can use either or, but both give us 2 LEDs
   PORTB = 0x0; //The ATmega328P on the UNO will be resetting, so unplug it?
 #endif
+  // Timer1 provides the millisecond clock the mission wait runs on.
+  Timer_Init();
+  // mission_time can be overridden from a PC, see params.h.
+  Params_Init(PARAMS_MISSION);
   // The USB stack should be initialized last.
   USB_Init();
 }
 
-// Fired to indicate that the device is enumerating.
-void EVENT_USB_Device_Connect(void) {
-  // We can indicate that we're enumerating here (via status LEDs, sound, etc.).
-}
-
-// Fired to indicate that the device is no longer connected to a host.
-void EVENT_USB_Device_Disconnect(void) {
-  // We can indicate that our device is not ready (via status LEDs, sound, etc.).
-}
-
-// Fired when the host set the current configuration of the USB device after enumeration.
-void EVENT_USB_Device_ConfigurationChanged(void) {
-  bool ConfigSuccess = true;
-
-  // We setup the HID report endpoints.
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-
-  // We can read ConfigSuccess to indicate a success or failure at this point.
-}
-
-// Process control requests sent to the device from the USB host.
-void EVENT_USB_Device_ControlRequest(void) {
-  // We can handle two control requests: a GetReport and a SetReport.
-
-  // Not used here, it looks like we don't receive control request from the Switch.
-}
-
-// Process and deliver data from IN and OUT endpoints.
-void HID_Task(void) {
-  // If the device isn't connected and properly configured, we can't do anything here.
-  if (USB_DeviceState != DEVICE_STATE_Configured)
-    return;
-
-  // We'll start with the OUT endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
-  // We'll check to see if we received something on the OUT endpoint.
-  if (Endpoint_IsOUTReceived()) {
-    // If we did, and the packet has data, we'll react to it.
-    if (Endpoint_IsReadWriteAllowed()) {
-      // We'll create a place to store our data received from the host.
-      USB_JoystickReport_Output_t JoystickOutputData;
-      // We'll then take in that data, setting it up in our storage.
-      while (Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL) !=
-          ENDPOINT_RWSTREAM_NoError);
-      // At this point, we can react to this data.
-
-      // However, since we're not doing anything with this data, we abandon it.
-    }
-    // Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
-    Endpoint_ClearOUT();
-  }
-
-  // We'll then move on to the IN endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
-  // We first check to see if the host is ready to accept data.
-  if (Endpoint_IsINReady()) {
-    // We'll create an empty report.
-    USB_JoystickReport_Input_t JoystickInputData;
-    // We'll then populate this report with what we want to send to the host.
-    GetNextReport(&JoystickInputData);
-    // Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
-    while (Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL) !=
-        ENDPOINT_RWSTREAM_NoError);
-    // We then send an IN packet on this endpoint.
-    Endpoint_ClearIN();
-  }
-}
-
 typedef enum {
   SYNC_CONTROLLER,
   PREPARE,
+  COLLECT,
   MISSION_1,
   MISSION_2,
   MISSION_3,
@@ -152,19 +96,23 @@ State_t state = SYNC_CONTROLLER;
 
 // region maps
 
-BUTTON_MAP_t prepare[] = {
+BUTTON_MAP_t backOut[] = {
     {BUTTON_B,    1000},
     {BUTTON_B,    1000},
     {BUTTON_B,    1000},
     {BUTTON_B,    1500},
+};
 
+BUTTON_MAP_t openMerc[] = {
     {BUTTON_PLUS, 1500},
     {PAD_RIGHT,   50},
     {PAD_RIGHT,   50},
     {PAD_RIGHT,   50},
     {PAD_RIGHT,   50},
     {BUTTON_A,    1000}, // 进入佣兵团
+};
 
+BUTTON_MAP_t collect[] = {
     {BUTTON_A,    1000}, // 确认任务1
     {BUTTON_B,    2000},
     {BUTTON_A,    1000}, // 1
@@ -235,8 +183,6 @@ BUTTON_MAP_t mission2[] = {
 };
 
 BUTTON_MAP_t mission3[] = {
-    {PAD_RIGHT, 100},
-    {PAD_RIGHT, 100},
     {BUTTON_A,  500}, // 进入商会
     {BUTTON_A,  1000}, // 任务3
 };
@@ -266,9 +212,25 @@ BUTTON_MAP_t startMission[] = {
 };
 // endregion
 
+// 佣兵团界面里商会一排 3 个，每次进来光标在第一个
+GRID_t companies = GRID(3, 3, 0);
+
+typedef enum {
+  SCREEN_FIELD,
+  SCREEN_MERC,
+} Screen_t;
+
+// 从任何界面按 B 退回野外，再从野外进佣兵团
+MENU_EDGE_t screens[] = {
+    MENU_EDGE(MENU_ANY, SCREEN_FIELD, backOut, NULL),
+    MENU_EDGE(SCREEN_FIELD, SCREEN_MERC, openMerc, &companies),
+};
+MENU_t menu = MENU(screens);
+
 int report_count = 0;
 int mapPos = 0;
-int mission_time = 30;
+int mission_time = 30; // minutes, unless set in EEPROM
+LONG_WAIT_t missionWait;
 
 bool holding = true;
 bool waiting = false;
@@ -281,9 +243,22 @@ uint8_t ports_val = 0;
 
 uint8_t mission_position = 0;
 
+// Moves the cursor to a company before its mission table runs; false once there.
+static bool walkCompany(USB_JoystickReport_Input_t *const ReportData, uint8_t company) {
+  ACTION_t action = Grid_Step(&companies, company);
+
+  if (action == BUTTON_RESET)
+    return false;
+  setButton(ReportData, action);
+  wait_time = 100;
+  return true;
+}
+
 // Prepare the next report for the host.
 void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
+  const BUTTON_MAP_t *step;
 
+  Telemetry_Mark(state, mapPos);
   setButton(ReportData, BUTTON_RESET);
 
   if (holding && hold_time) {
@@ -310,9 +285,9 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
         wait_time = 500;
         mapPos = 0;
         state = PREPARE;
+        Menu_Goto(&menu, SCREEN_MERC);
       } else if (report_count == 25 || report_count == 50) {
-        setButton(ReportData, BUTTON_L);
-        setButton(ReportData, BUTTON_R);
+        setChord(ReportData, BUTTON_L, BUTTON_R);
       } else if (report_count == 75 || report_count == 100) {
         setButton(ReportData, BUTTON_A);
       }
@@ -321,17 +296,30 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       //hold_time = 50;
       break;
     case PREPARE:
-      setButton(ReportData, prepare[mapPos].action);
-      wait_time = prepare[mapPos].wait_time;
+      step = Menu_Next(&menu);
+      if (step) {
+        setButton(ReportData, step->action);
+        wait_time = step->wait_time;
+        break;
+      }
+      if (walkCompany(ReportData, 0))
+        break;
+      state = COLLECT;
+      // fall through
+    case COLLECT:
+      setButton(ReportData, collect[mapPos].action);
+      wait_time = collect[mapPos].wait_time;
 
       mapPos++;
-      if (mapPos >= (sizeof(prepare) / sizeof(BUTTON_MAP_t))) {
+      if (mapPos >= (sizeof(collect) / sizeof(BUTTON_MAP_t))) {
         state = MISSION_1;
         mission_position = 0;
         mapPos = 0;
       }
       break;
     case MISSION_1:
+      if (walkCompany(ReportData, 0))
+        break;
       setButton(ReportData, mission1[mapPos].action);
       wait_time = mission1[mapPos].wait_time;
 
@@ -342,6 +330,8 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       }
       break;
     case MISSION_2:
+      if (walkCompany(ReportData, 0))
+        break;
       setButton(ReportData, mission2[mapPos].action);
       wait_time = mission2[mapPos].wait_time;
 
@@ -352,6 +342,8 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       }
       break;
     case MISSION_3:
+      if (walkCompany(ReportData, 2))
+        break;
       setButton(ReportData, mission3[mapPos].action);
       wait_time = mission3[mapPos].wait_time;
 
@@ -377,35 +369,27 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
 
       mapPos++;
       if (mapPos >= (sizeof(startMission) / sizeof(BUTTON_MAP_t))) {
-        state = WAITING;
-        mission_time = 30;
         mapPos = 0;
         mission_position++;
         if (mission_position % 3 == 1) {
           state = MISSION_2;
         } else if (mission_position % 3 == 2) {
           state = MISSION_3;
+        } else {
+          state = WAITING;
+          LongWait_Start(&missionWait, Params_Get(PARAM_MISSION_TIME, mission_time) * 60000UL);
         }
       }
       break;
     case WAITING:
-      while (mission_time) {
-        _delay_ms(60000);
-        mission_time--;
-      }
-      mission_time = 0;
+      // Neutral reports keep the controller alive; no hold/wait in between.
+      if (LongWait_Pending(&missionWait))
+        return;
       mapPos = 0;
       state = PREPARE;
-      //if (mission_time > 0) {
-      //  _delay_ms(60000);
-      //  mission_time--;
-      //  setButton(ReportData, BUTTON_B);
-      //  hold_time = 50;
-      //  wait_time = 0;
-      //} else {
-      //  mission_time = 0;
-      //  state = PREPARE;
-      //}
+      // 等了半个小时，谁知道中间弹过什么窗，每轮都先按 B 退回野外
+      Menu_Lost(&menu);
+      Menu_Goto(&menu, SCREEN_MERC);
       break;
     }
     // endregion
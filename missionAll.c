@@ -26,6 +26,11 @@ these buttons for our use.
 
 #include "Joystick.h"
 #include "action.h"
+#include "grid.h"
+#include "idle.h"
+#include "params.h"
+#include "telemetry.h"
+#include "timer.h"
 #ifndef ALERT_WHEN_DONE
 #define ALERT_WHEN_DONE
 #endif
@@ -42,6 +47,8 @@ int main(void) {
     HID_Task();
     // We also need to run the main USB management task.
     USB_USBTask();
+    // Then doze until the next timer tick or USB interrupt.
+    Idle_Sleep();
   }
 }
 
@@ -65,83 +72,20 @@ PORTD will toggle when printing is done.
   DDRB = 0xFF; //uses PORTB. Micro can use either or, but both give us 2 LEDs
   PORTB = 0x0; //The ATmega328P on the UNO will be resetting, so unplug it?
 #endif
+  // Timer1 provides the millisecond clock the mission wait runs on.
+  Timer_Init();
+  // mission_time can be overridden from a PC, see params.h.
+  Params_Init(PARAMS_MISSION_ALL);
   // The USB stack should be initialized last.
   USB_Init();
 }
 
-// Fired to indicate that the device is enumerating.
-void EVENT_USB_Device_Connect(void) {
-  // We can indicate that we're enumerating here (via status LEDs, sound, etc.).
-}
-
-// Fired to indicate that the device is no longer connected to a host.
-void EVENT_USB_Device_Disconnect(void) {
-  // We can indicate that our device is not ready (via status LEDs, sound, etc.).
-}
-
-// Fired when the host set the current configuration of the USB device after enumeration.
-void EVENT_USB_Device_ConfigurationChanged(void) {
-  bool ConfigSuccess = true;
-
-  // We setup the HID report endpoints.
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-
-  // We can read ConfigSuccess to indicate a success or failure at this point.
-}
-
-// Process control requests sent to the device from the USB host.
-void EVENT_USB_Device_ControlRequest(void) {
-  // We can handle two control requests: a GetReport and a SetReport.
-
-  // Not used here, it looks like we don't receive control request from the Switch.
-}
-
-// Process and deliver data from IN and OUT endpoints.
-void HID_Task(void) {
-  // If the device isn't connected and properly configured, we can't do anything here.
-  if (USB_DeviceState != DEVICE_STATE_Configured)
-    return;
-
-  // We'll start with the OUT endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
-  // We'll check to see if we received something on the OUT endpoint.
-  if (Endpoint_IsOUTReceived()) {
-    // If we did, and the packet has data, we'll react to it.
-    if (Endpoint_IsReadWriteAllowed()) {
-      // We'll create a place to store our data received from the host.
-      USB_JoystickReport_Output_t JoystickOutputData;
-      // We'll then take in that data, setting it up in our storage.
-      while (Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL) !=
-          ENDPOINT_RWSTREAM_NoError);
-      // At this point, we can react to this data.
-
-      // However, since we're not doing anything with this data, we abandon it.
-    }
-    // Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
-    Endpoint_ClearOUT();
-  }
-
-  // We'll then move on to the IN endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
-  // We first check to see if the host is ready to accept data.
-  if (Endpoint_IsINReady()) {
-    // We'll create an empty report.
-    USB_JoystickReport_Input_t JoystickInputData;
-    // We'll then populate this report with what we want to send to the host.
-    GetNextReport(&JoystickInputData);
-    // Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
-    while (Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL) !=
-        ENDPOINT_RWSTREAM_NoError);
-    // We then send an IN packet on this endpoint.
-    Endpoint_ClearIN();
-  }
-}
-
 typedef enum {
   SYNC_CONTROLLER,
   PREPARE,
+  CHOOSE_MISSION,
   CHOOSE_PEOPLE,
+  CONFIRM_PEOPLE,
   START_MISSION,
   WAITING
 } State_t;
@@ -189,36 +133,20 @@ BUTTON_MAP_t chooseMap[] = {
     {PAD_RIGHT,  50},
     {PAD_BOTTOM, 50},
     {BUTTON_A,   1000}, // 任务1
+};
 
-    {PAD_BOTTOM, 50},
-    {PAD_BOTTOM, 50},
-    {PAD_RIGHT,  50},
-    {PAD_RIGHT,  50},
-    {PAD_RIGHT,  50},
-    {BUTTON_A,   50}, // 七冰
-    {PAD_BOTTOM, 50},
-    {PAD_BOTTOM, 50},
-    {PAD_RIGHT,  50},
-    {BUTTON_A,   50}, // 月
-    {PAD_BOTTOM, 50},
-    {PAD_LEFT,   50},
-    {BUTTON_A,   50}, // 路人暗
-    {PAD_BOTTOM, 50},
-    {PAD_LEFT,   50},
-    {PAD_LEFT,   50},
-    {PAD_LEFT,   50},
-    {BUTTON_A,   50},  // 路人暗
-    {PAD_BOTTOM, 50},
-    {PAD_BOTTOM, 50},
-    {PAD_BOTTOM, 50},
-    {PAD_BOTTOM, 50},
-    {PAD_RIGHT,  50},
-    {PAD_RIGHT,  50},
-    {PAD_RIGHT,  50},
-    {BUTTON_A,   50},  // 路人暗
-    {PAD_BOTTOM, 50},
-    {BUTTON_A,   50},  // 路人暗
+// 选人界面一行 5 个，进来时光标在第一个，按顺序选这些格子
+uint8_t people[] = {
+    13, // 七冰
+    24, // 月
+    28, // 路人暗
+    30, // 路人暗
+    53, // 路人暗
+    58, // 路人暗
+};
+GRID_t peopleGrid = GRID(5, 60, 0);
 
+BUTTON_MAP_t confirmMap[] = {
     {BUTTON_X,   1000},
     {BUTTON_A,   500},
     {PAD_TOP,    100},
@@ -241,13 +169,16 @@ bool waiting = false;
 #define DEFAULT_HOLD_TIME 50
 int hold_time = DEFAULT_HOLD_TIME;
 int wait_time = 50;
-int mission_time = 30;
+int mission_time = 7; // minutes, unless set in EEPROM
+LONG_WAIT_t missionWait;
 
 uint8_t ports_val = 0;
 
 // Prepare the next report for the host.
 void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
+  ACTION_t action;
 
+  Telemetry_Mark(state, mapPos);
   setButton(ReportData, BUTTON_RESET);
 
   if (holding && hold_time) {
@@ -275,8 +206,7 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
         mapPos = 0;
         state = PREPARE;
       } else if (report_count == 25 || report_count == 50) {
-        setButton(ReportData, BUTTON_L);
-        setButton(ReportData, BUTTON_R);
+        setChord(ReportData, BUTTON_L, BUTTON_R);
       } else if (report_count == 75 || report_count == 100) {
         setButton(ReportData, BUTTON_A);
       }
@@ -289,16 +219,41 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
 
       mapPos++;
       if (mapPos >= (sizeof(prepareMap) / sizeof(BUTTON_MAP_t))) {
-        state = CHOOSE_PEOPLE;
+        state = CHOOSE_MISSION;
         mapPos = 0;
       }
       break;
-    case CHOOSE_PEOPLE:
+    case CHOOSE_MISSION:
       setButton(ReportData, chooseMap[mapPos].action);
       wait_time = chooseMap[mapPos].wait_time;
 
       mapPos++;
       if (mapPos >= (sizeof(chooseMap) / sizeof(BUTTON_MAP_t))) {
+        state = CHOOSE_PEOPLE;
+        Grid_Reset(&peopleGrid, 0);
+        mapPos = 0;
+      }
+      break;
+    case CHOOSE_PEOPLE:
+      wait_time = 50;
+      action = Grid_Step(&peopleGrid, people[mapPos]);
+      if (action != BUTTON_RESET) {
+        setButton(ReportData, action);
+        break;
+      }
+      setButton(ReportData, BUTTON_A);
+      mapPos++;
+      if (mapPos >= sizeof(people)) {
+        state = CONFIRM_PEOPLE;
+        mapPos = 0;
+      }
+      break;
+    case CONFIRM_PEOPLE:
+      setButton(ReportData, confirmMap[mapPos].action);
+      wait_time = confirmMap[mapPos].wait_time;
+
+      mapPos++;
+      if (mapPos >= (sizeof(confirmMap) / sizeof(BUTTON_MAP_t))) {
         state = START_MISSION;
         mapPos = 0;
       }
@@ -310,28 +265,16 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       mapPos++;
       if (mapPos >= (sizeof(startMissionMap) / sizeof(BUTTON_MAP_t))) {
         state = WAITING;
-        mission_time = 7;
+        LongWait_Start(&missionWait, Params_Get(PARAM_MISSION_TIME, mission_time) * 60000UL);
         mapPos = 0;
       }
       break;
     case WAITING:
-      while (mission_time) {
-        _delay_ms(60000);
-        mission_time--;
-      }
-      mission_time = 0;
+      // Neutral reports keep the controller alive; no hold/wait in between.
+      if (LongWait_Pending(&missionWait))
+        return;
       mapPos = 0;
       state = PREPARE;
-      //if (mission_time > 0) {
-      //  _delay_ms(60000);
-      //  mission_time--;
-      //  setButton(ReportData, BUTTON_B);
-      //  hold_time = 50;
-      //  wait_time = 0;
-      //} else {
-      //  mission_time = 0;
-      //  state = PREPARE;
-      //}
       break;
     }
     // endregion
@@ -26,6 +26,10 @@ these buttons for our use.
 
 #include "Joystick.h"
 #include "action.h"
+#include "idle.h"
+#include "sequencer.h"
+#include "telemetry.h"
+#include "timer.h"
 
 // Main entry point.
 int main(void) {
@@ -39,6 +43,8 @@ int main(void) {
     HID_Task();
     // We also need to run the main USB management task.
     USB_USBTask();
+    // Then doze until the next timer tick or USB interrupt.
+    Idle_Sleep();
   }
 }
 
@@ -62,84 +68,17 @@ PORTD will toggle when printing is done.
   DDRB = 0xFF; //uses PORTB. Micro can use either or, but both give us 2 LEDs
   PORTB = 0x0; //The ATmega328P on the UNO will be resetting, so unplug it?
 #endif
+  // Timer1 provides the millisecond clock the stick routes are timed with.
+  Timer_Init();
   // The USB stack should be initialized last.
   USB_Init();
 }
 
-// Fired to indicate that the device is enumerating.
-void EVENT_USB_Device_Connect(void) {
-  // We can indicate that we're enumerating here (via status LEDs, sound, etc.).
-}
-
-// Fired to indicate that the device is no longer connected to a host.
-void EVENT_USB_Device_Disconnect(void) {
-  // We can indicate that our device is not ready (via status LEDs, sound, etc.).
-}
-
-// Fired when the host set the current configuration of the USB device after enumeration.
-void EVENT_USB_Device_ConfigurationChanged(void) {
-  bool ConfigSuccess = true;
-
-  // We setup the HID report endpoints.
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-  ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-
-  // We can read ConfigSuccess to indicate a success or failure at this point.
-}
-
-// Process control requests sent to the device from the USB host.
-void EVENT_USB_Device_ControlRequest(void) {
-  // We can handle two control requests: a GetReport and a SetReport.
-
-  // Not used here, it looks like we don't receive control request from the Switch.
-}
-
-// Process and deliver data from IN and OUT endpoints.
-void HID_Task(void) {
-  // If the device isn't connected and properly configured, we can't do anything here.
-  if (USB_DeviceState != DEVICE_STATE_Configured)
-    return;
-
-  // We'll start with the OUT endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
-  // We'll check to see if we received something on the OUT endpoint.
-  if (Endpoint_IsOUTReceived()) {
-    // If we did, and the packet has data, we'll react to it.
-    if (Endpoint_IsReadWriteAllowed()) {
-      // We'll create a place to store our data received from the host.
-      USB_JoystickReport_Output_t JoystickOutputData;
-      // We'll then take in that data, setting it up in our storage.
-      while (Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL) !=
-          ENDPOINT_RWSTREAM_NoError);
-      // At this point, we can react to this data.
-
-      // However, since we're not doing anything with this data, we abandon it.
-    }
-    // Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
-    Endpoint_ClearOUT();
-  }
-
-  // We'll then move on to the IN endpoint.
-  Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
-  // We first check to see if the host is ready to accept data.
-  if (Endpoint_IsINReady()) {
-    // We'll create an empty report.
-    USB_JoystickReport_Input_t JoystickInputData;
-    // We'll then populate this report with what we want to send to the host.
-    GetNextReport(&JoystickInputData);
-    // Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
-    while (Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL) !=
-        ENDPOINT_RWSTREAM_NoError);
-    // We then send an IN packet on this endpoint.
-    Endpoint_ClearIN();
-  }
-}
-
 typedef enum {
   SYNC_CONTROLLER,
   SEND,
   RUN,
-  OPEN,
+  PICK,
 } State_t;
 State_t state = SYNC_CONTROLLER;
 
@@ -152,12 +91,19 @@ BUTTON_MAP_t send[] = {
     {BUTTON_A, 5000},
 };
 
-BUTTON_MAP_t run[] = {
-    {L_STICK_TOP,   5000},
-    {L_STICK_RIGHT, 300},
-    {L_STICK_TOP,   6300}
+// 上 5000 / 右 300 / 上 6300
+const STICK_MAP_t run[] PROGMEM = {
+    {STICK_CENTER, STICK_MIN,    0, 5000, STICK_LINEAR},
+    {STICK_MAX,    STICK_CENTER, 0, 300,  STICK_LINEAR},
+    {STICK_CENTER, STICK_MIN,    0, 6300, STICK_LINEAR},
+};
+
+INPUT_MAP_t pick[] = {
+    INPUT_BUTTON(SWITCH_A, 80, 11000), // 采集
 };
 
+SEQUENCER_t sequencer;
+
 int report_count = 0;
 
 bool holding = true;
@@ -170,6 +116,7 @@ int mapPos = 0;
 // Prepare the next report for the host.
 void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
 
+  Telemetry_Mark(state, mapPos);
   setButton(ReportData, BUTTON_RESET);
 
   if (holding && hold_time) {
@@ -195,8 +142,7 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
         report_count = 0;
         state = SEND;
       } else if (report_count == 25 || report_count == 50) {
-        setButton(ReportData, BUTTON_L);
-        setButton(ReportData, BUTTON_R);
+        setChord(ReportData, BUTTON_L, BUTTON_R);
       } else if (report_count == 75 || report_count == 100) {
         setButton(ReportData, BUTTON_A);
       }
@@ -210,32 +156,30 @@ void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
       mapPos++;
       if (mapPos >= (sizeof(send) / sizeof(BUTTON_MAP_t))) {
         state = RUN;
+        Sequencer_Init(&sequencer);
+        Sequencer_SetLStick(&sequencer, run, sizeof(run) / sizeof(STICK_MAP_t));
         mapPos = 0;
       }
       break;
     case RUN:
-      setButton(ReportData, run[mapPos].action);
-      hold_time = run[mapPos].wait_time;
-      wait_time = 0;
+      // The tracks drive the report on every poll, without hold/wait gaps.
+      if (Sequencer_Next(&sequencer, ReportData))
+        return;
+      // Let the character settle before the pick.
+      wait_time = 1000;
+      state = PICK;
+      break;
+    case PICK:
+      setInput(ReportData, &pick[mapPos]);
+      hold_time = pick[mapPos].hold_time;
+      wait_time = pick[mapPos].wait_time;
 
       mapPos++;
-      if (mapPos >= (sizeof(run) / sizeof(BUTTON_MAP_t))) {
-        state = OPEN;
-        wait_time = 1000;
+      if (mapPos >= (sizeof(pick) / sizeof(INPUT_MAP_t))) {
+        state = SEND;
         mapPos = 0;
       }
       break;
-    case OPEN:
-      setButton(ReportData, BUTTON_A);
-      hold_time = 80;
-      wait_time = 11000;
-
-      //mapPos++;
-      //if (mapPos >= 350) { // 差不多10次吃一个
-      state = SEND;
-      mapPos = 0;
-      //}
-      break;
     }
     // endregion
     if (!hold_time) hold_time = 50;
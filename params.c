@@ -0,0 +1,101 @@
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <util/crc16.h>
+
+#include "params.h"
+
+typedef struct {
+    uint8_t program;
+    uint8_t set;
+    uint16_t values[PARAM_COUNT];
+    uint16_t crc;
+} PARAMS_BLOCK_t;
+
+// The parameters each program reads.
+static const uint8_t used[] = {
+    [PARAMS_EAT_MEAT] = 1 << PARAM_BLADE_NUM | 1 << PARAM_BLADE_POS,
+    [PARAMS_MISSION] = 1 << PARAM_MISSION_TIME,
+    [PARAMS_MISSION_ALL] = 1 << PARAM_MISSION_TIME,
+};
+
+// Lowest and highest value of each parameter.
+static const uint16_t limits[PARAM_COUNT][2] PROGMEM = {
+    [PARAM_BLADE_NUM] = {2, 255}, // GRID_t counts the blades in a byte
+    [PARAM_BLADE_POS] = {1, 254},
+    [PARAM_MISSION_TIME] = {1, 1440}, // a day
+};
+
+static PARAMS_BLOCK_t EEMEM stored;
+static PARAMS_BLOCK_t block;
+
+static uint16_t crc(const PARAMS_BLOCK_t *b) {
+    const uint8_t *p = (const uint8_t *) b;
+    uint16_t value = 0xFFFF;
+    uint8_t n;
+
+    for (n = 0; n < offsetof(PARAMS_BLOCK_t, crc); n++)
+        value = _crc16_update(value, p[n]);
+    return value;
+}
+
+static void save(void) {
+    block.crc = crc(&block);
+    // Only the bytes that changed are written, which spares the EEPROM.
+    eeprom_update_block(&block, &stored, sizeof(block));
+}
+
+void Params_Init(PARAMS_PROGRAM_t program) {
+    eeprom_read_block(&block, &stored, sizeof(block));
+    if (block.crc != crc(&block) || block.program != program) {
+        memset(&block, 0, sizeof(block));
+        block.program = program;
+        save();
+    }
+}
+
+uint16_t Params_Get(PARAM_t id, uint16_t fallback) {
+    return (block.set & (1 << id)) ? block.values[id] : fallback;
+}
+
+static uint8_t used_mask(void) {
+    // PARAMS_NONE until Params_Init(), in programs that keep no parameters.
+    return block.program < sizeof(used) ? used[block.program] : 0;
+}
+
+bool Params_Used(uint8_t id) {
+    return id < PARAM_COUNT && (used_mask() & (1 << id));
+}
+
+bool Params_InRange(uint8_t id, uint16_t value, uint8_t set, const uint16_t *values) {
+    if (id >= PARAM_COUNT || value < pgm_read_word(&limits[id][0]) || value > pgm_read_word(&limits[id][1]))
+        return false;
+    // eatMeat feeds the blades after blade_pos, up to blade_num.
+    if (id == PARAM_BLADE_POS && (set & (1 << PARAM_BLADE_NUM)))
+        return value < values[PARAM_BLADE_NUM];
+    if (id == PARAM_BLADE_NUM && (set & (1 << PARAM_BLADE_POS)))
+        return value > values[PARAM_BLADE_POS];
+    return true;
+}
+
+bool Params_Valid(uint8_t id, uint16_t value) {
+    return Params_Used(id) && Params_InRange(id, value, block.set, block.values);
+}
+
+bool Params_Set(uint8_t id, uint16_t value) {
+    if (!Params_Valid(id, value))
+        return false;
+    block.values[id] = value;
+    block.set |= 1 << id;
+    save();
+    return true;
+}
+
+void Params_Report(PARAMS_REPORT_t *report) {
+    report->report_id = PARAMS_REPORT_ID;
+    report->program = block.program;
+    report->set = block.set;
+    report->used = used_mask();
+    memcpy(report->values, block.values, sizeof(report->values));
+}
@@ -0,0 +1,75 @@
+#ifndef _PARAMS_H_
+#define _PARAMS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Runtime parameters kept in EEPROM, so a run can be reconfigured from a PC
+// in seconds instead of editing the source and reflashing. The block
+// remembers which program wrote it and is CRC-checked; a parameter that was
+// never set (or belongs to another program) reads back the program's default.
+//
+// Set them with a Feature SetReport (report ID PARAMS_REPORT_ID, see
+// host/paramctl) in any build, or with the stream SET command in
+// with-stream/with-uart builds. Programs read them at startup. Only the
+// parameters the running program reads can be set, and none in programs
+// without parameters, so that the one block is never saved over by a
+// program that does not own it. Values out of a parameter's range are
+// refused as well (Params_InRange()).
+typedef enum {
+  PARAM_BLADE_NUM,    // eatMeat: 喂到第几个异刃结束
+  PARAM_BLADE_POS,    // eatMeat: 从第几个异刃开始
+  PARAM_MISSION_TIME, // mission, missionAll: 任务时间（分钟）
+  PARAM_COUNT,
+} PARAM_t;
+
+// Programs that keep parameters or counters (stats.h).
+typedef enum {
+  PARAMS_NONE,
+  PARAMS_EAT_MEAT,
+  PARAMS_MISSION,
+  PARAMS_MISSION_ALL,
+  PARAMS_TO_SS,
+} PARAMS_PROGRAM_t;
+
+#define PARAMS_REPORT_ID 1
+
+// Feature report PARAMS_REPORT_ID as read by the host.
+typedef struct __attribute__((packed)) {
+  uint8_t report_id;
+  uint8_t program;
+  uint8_t set;  // bit n: parameter n has been set
+  uint8_t used; // bit n: the program reads parameter n
+  uint16_t values[PARAM_COUNT];
+} PARAMS_REPORT_t;
+
+// Feature report PARAMS_REPORT_ID as written by the host.
+typedef struct __attribute__((packed)) {
+  uint8_t report_id;
+  uint8_t id;
+  uint16_t value;
+} PARAMS_SET_REPORT_t;
+
+// Loads the block, starting a fresh one if it is corrupt or another program's.
+void Params_Init(PARAMS_PROGRAM_t program);
+
+// The saved value of a parameter, or `fallback` if it has not been set.
+uint16_t Params_Get(PARAM_t id, uint16_t fallback);
+
+// Whether the running program reads parameter `id`, so that it can be set.
+bool Params_Used(uint8_t id);
+
+// Whether `value` is within parameter `id`'s bounds, given the parameters
+// already set (as in PARAMS_REPORT_t). blade_pos must stay below blade_num
+// when that is set, and the other way round. Also used by host/paramctl.
+bool Params_InRange(uint8_t id, uint16_t value, uint8_t set, const uint16_t *values);
+
+// Whether the running program would take `value` for parameter `id`.
+bool Params_Valid(uint8_t id, uint16_t value);
+
+// Saves a parameter; false unless Params_Valid(id, value).
+bool Params_Set(uint8_t id, uint16_t value);
+
+void Params_Report(PARAMS_REPORT_t *report);
+
+#endif
@@ -0,0 +1,64 @@
+#include <string.h>
+
+#include "profile.h"
+#include "timer.h"
+
+#ifdef PROFILE
+
+typedef struct {
+    uint32_t start;
+    uint32_t slept;
+} SPAN_t;
+
+uint32_t profile_slept;
+
+static SPAN_t spans[PROFILE_REGIONS + 1]; // the last one measures the overhead
+static uint32_t cleared_ms;
+static PROFILE_REPORT_t report = {
+    .report_id = PROFILE_REPORT_ID,
+    .count = PROFILE_REGIONS,
+    .cycles_per_ms = TIMER_CYCLES_PER_MS,
+};
+
+static void begin(SPAN_t *span) {
+    span->slept = profile_slept;
+    span->start = Timer_Cycles();
+}
+
+static uint32_t end(const SPAN_t *span) {
+    uint32_t now = Timer_Cycles();
+
+    return now - span->start - (profile_slept - span->slept);
+}
+
+void Profile_Begin(uint8_t region) {
+    begin(&spans[region]);
+}
+
+void Profile_End(uint8_t region) {
+    uint32_t cycles = end(&spans[region]);
+    PROFILE_STATS_t *stats = &report.regions[region];
+
+    if (!stats->count || cycles < stats->min)
+        stats->min = cycles;
+    if (cycles > stats->max)
+        stats->max = cycles;
+    stats->total += cycles;
+    stats->count++;
+}
+
+void Profile_Reset(void) {
+    memset(report.regions, 0, sizeof(report.regions));
+    cleared_ms = millis();
+}
+
+PROFILE_REPORT_t *Profile_Report(void) {
+    SPAN_t *calibration = &spans[PROFILE_REGIONS];
+
+    begin(calibration);
+    report.overhead = end(calibration);
+    report.ms = millis() - cleared_ms;
+    return &report;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Cycle counts of the hot path, for seeing how much of each 1 ms frame a
+// program's state switch or printImage's pixel fetch costs. Build with
+// PROFILE (make with-profile); otherwise PROFILE_BEGIN/END compile to nothing.
+//
+// Each region keeps count, min, max and total Timer1 cycles from
+// PROFILE_BEGIN to PROFILE_END, less the time spent asleep in Idle_Sleep()
+// in between, so the blocking delay() of the programs doesn't count. USB
+// interrupts that fire inside a region do. Read them with Feature report
+// PROFILE_REPORT_ID (host/profctl); a SetReport of the report ID clears them.
+//
+// PROFILE_STROBE_PIN is also driven high for the length of the
+// PROFILE_STROBE region, for a scope or logic analyser. The default is PC7,
+// as no program drives PORTC; PORTB and PORTD are written whole by
+// ALERT_WHEN_DONE, which eatMeat, mission and openCard always define.
+typedef enum {
+  PROFILE_HID_TASK,
+  PROFILE_GET_NEXT_REPORT,
+  PROFILE_SET_BUTTON,
+  PROFILE_WRITE_STREAM, // Endpoint_Write_Stream_LE() of the IN report
+  PROFILE_USB_TASK,
+  PROFILE_REGIONS
+} PROFILE_REGION_t;
+
+#ifndef PROFILE_STROBE_BIT
+#define PROFILE_STROBE_PORT PORTC
+#define PROFILE_STROBE_DDR  DDRC
+#define PROFILE_STROBE_BIT  7
+#endif
+#ifndef PROFILE_STROBE
+#define PROFILE_STROBE PROFILE_HID_TASK
+#endif
+
+#define PROFILE_REPORT_ID 5
+
+typedef struct __attribute__((packed)) {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+} PROFILE_STATS_t;
+
+// Feature report PROFILE_REPORT_ID as read by the host.
+typedef struct __attribute__((packed)) {
+  uint8_t report_id;
+  uint8_t count;          // PROFILE_REGIONS
+  uint16_t cycles_per_ms;
+  uint16_t overhead;      // about what an empty region measures; not taken off the others
+  uint32_t ms;            // since the counters were cleared
+  PROFILE_STATS_t regions[PROFILE_REGIONS];
+} PROFILE_REPORT_t;
+
+#ifdef PROFILE
+
+// Added to by Idle_Sleep().
+extern uint32_t profile_slept;
+
+void Profile_Begin(uint8_t region);
+void Profile_End(uint8_t region);
+void Profile_Reset(void);
+PROFILE_REPORT_t *Profile_Report(void);
+
+#define PROFILE_BEGIN(region) do { \
+    if ((region) == PROFILE_STROBE) { \
+      PROFILE_STROBE_DDR |= (1 << PROFILE_STROBE_BIT); \
+      PROFILE_STROBE_PORT |= (1 << PROFILE_STROBE_BIT); \
+    } \
+    Profile_Begin(region); \
+  } while (0)
+
+#define PROFILE_END(region) do { \
+    Profile_End(region); \
+    if ((region) == PROFILE_STROBE) \
+      PROFILE_STROBE_PORT &= ~(1 << PROFILE_STROBE_BIT); \
+  } while (0)
+
+#else
+
+#define PROFILE_BEGIN(region) do {} while (0)
+#define PROFILE_END(region)   do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+#include "resync.h"
+#include "eventlog.h"
+#include "feedback.h"
+#include "telemetry.h"
+#include "timer.h"
+
+static void report(const RESYNC_t *resync) {
+#ifdef TELEMETRY
+    telemetry.resyncs = resync->resyncs;
+    telemetry.resync_requests = resync->requests;
+    telemetry.resyncs_per_hour = Resync_PerHour(resync);
+#else
+    (void) resync;
+#endif
+}
+
+bool Resync_Due(RESYNC_t *resync) {
+    if (!resync->resyncs && !resync->loops)
+        resync->since = millis();
+#ifdef FEEDBACK_INPUT
+    if (feedback_stats.timeouts != resync->timeouts) {
+        resync->timeouts = feedback_stats.timeouts;
+        resync->requested = true;
+    }
+#endif
+    resync->loops++;
+    if (!resync->requested && !(resync->every && resync->loops >= resync->every)) {
+        report(resync);
+        return false;
+    }
+
+    if (resync->requested)
+        resync->requests++;
+    resync->resyncs++;
+    EventLog_Add(EVENTLOG_RESYNC, resync->requested);
+    resync->requested = false;
+    resync->loops = 0;
+    resync->pos = 0;
+    report(resync);
+    return true;
+}
+
+const BUTTON_MAP_t *Resync_Next(RESYNC_t *resync) {
+    if (resync->pos >= resync->count)
+        return NULL;
+    return &resync->steps[resync->pos++];
+}
+
+uint16_t Resync_PerHour(const RESYNC_t *resync) {
+    uint32_t elapsed = millis() - resync->since;
+
+    if (elapsed < 60000)
+        return 0;
+    return (uint32_t) resync->resyncs * 3600000UL / elapsed;
+}
@@ -0,0 +1,47 @@
+#ifndef _RESYNC_H_
+#define _RESYNC_H_
+
+#include "action.h"
+
+// A resync anchor for farming loops. One dropped input can leave a loop
+// pressing buttons on the wrong screen for hours; the anchor sits where the
+// loop restarts and, every `every` loops or when asked to, plays a known-good
+// escape (B presses back to the field) before the loop's own first table
+// enters the menus again from a known place.
+//
+// With FEEDBACK_INPUT, an UNTIL_READY() wait that timed out (the console never
+// showed a loading screen, see feedback.h) also asks for a resync at the next
+// anchor.
+typedef struct {
+  const BUTTON_MAP_t *steps;
+  uint8_t count;
+  uint8_t pos;        // step being played, `count` when not resyncing
+  uint16_t every;     // loops between resyncs, 0 for only when asked
+  uint16_t loops;     // since the last resync
+  bool requested;
+  uint16_t timeouts;  // feedback_stats.timeouts already acted on
+  uint16_t resyncs;   // all of them
+  uint16_t requests;  // of which asked for
+  uint32_t since;     // millis() of the first Resync_Due()
+} RESYNC_t;
+
+// Static initializer for a BUTTON_MAP_t escape table.
+#define RESYNC(steps, every) \
+  {(steps), sizeof(steps) / sizeof(BUTTON_MAP_t), sizeof(steps) / sizeof(BUTTON_MAP_t), (every)}
+
+// Resync at the next anchor, e.g. when a program sees it is lost.
+static inline void Resync_Request(RESYNC_t *resync) {
+  resync->requested = true;
+}
+
+// Call once per loop at the anchor. True if a resync is due, which is then
+// started: play Resync_Next() until it returns NULL.
+bool Resync_Due(RESYNC_t *resync);
+
+const BUTTON_MAP_t *Resync_Next(RESYNC_t *resync);
+
+// Resyncs per hour since the first Resync_Due(), 0 in the first minute.
+// In TELEMETRY builds, Resync_Due() copies it and the counts to telemetry.h's report.
+uint16_t Resync_PerHour(const RESYNC_t *resync);
+
+#endif
@@ -0,0 +1,85 @@
+#include "sequencer.h"
+#include "timer.h"
+
+static void setTrack(TRACK_t *track, const TRACK_MAP_t *steps, uint8_t count, uint8_t loop_from) {
+    track->steps = steps;
+    track->count = count;
+    track->pos = 0;
+    track->loop_from = loop_from;
+}
+
+// Returns true while the track has a current step; `value` is then updated.
+static bool nextTrack(TRACK_t *track, uint32_t now, uint16_t *value) {
+    while (track->pos < track->count) {
+        TRACK_MAP_t step;
+
+        memcpy_P(&step, &track->steps[track->pos], sizeof(step));
+        if (now - track->since < step.time) {
+            *value = step.value;
+            return true;
+        }
+        track->since += step.time;
+        track->pos++;
+        if (track->pos >= track->count && track->loop_from < track->count)
+            track->pos = track->loop_from;
+    }
+    return false;
+}
+
+void Sequencer_Init(SEQUENCER_t *seq) {
+    setTrack(&seq->button, NULL, 0, TRACK_NO_LOOP);
+    setTrack(&seq->hat, NULL, 0, TRACK_NO_LOOP);
+    StickRoute_Start(&seq->l_stick, NULL, 0);
+    StickRoute_Start(&seq->r_stick, NULL, 0);
+    seq->started = false;
+}
+
+void Sequencer_SetButtons(SEQUENCER_t *seq, const TRACK_MAP_t *steps, uint8_t count, uint8_t loop_from) {
+    setTrack(&seq->button, steps, count, loop_from);
+}
+
+void Sequencer_SetHat(SEQUENCER_t *seq, const TRACK_MAP_t *steps, uint8_t count, uint8_t loop_from) {
+    setTrack(&seq->hat, steps, count, loop_from);
+}
+
+void Sequencer_SetLStick(SEQUENCER_t *seq, const STICK_MAP_t *points, uint8_t count) {
+    StickRoute_Start(&seq->l_stick, points, count);
+}
+
+void Sequencer_SetRStick(SEQUENCER_t *seq, const STICK_MAP_t *points, uint8_t count) {
+    StickRoute_Start(&seq->r_stick, points, count);
+}
+
+bool Sequencer_Next(SEQUENCER_t *seq, USB_JoystickReport_Input_t *const ReportData) {
+    uint32_t now = millis();
+    uint16_t button = 0;
+    uint16_t hat = HAT_CENTER;
+    bool running = false;
+
+    if (!seq->started) {
+        seq->button.since = now;
+        seq->hat.since = now;
+        seq->started = true;
+    }
+
+    ReportData->LX = STICK_CENTER;
+    ReportData->LY = STICK_CENTER;
+    ReportData->RX = STICK_CENTER;
+    ReportData->RY = STICK_CENTER;
+    // Stick routes never loop, so they always count towards `running`.
+    running |= StickRoute_Next(&seq->l_stick, &ReportData->LX, &ReportData->LY);
+    running |= StickRoute_Next(&seq->r_stick, &ReportData->RX, &ReportData->RY);
+    if (nextTrack(&seq->button, now, &button) && seq->button.loop_from == TRACK_NO_LOOP)
+        running = true;
+    if (nextTrack(&seq->hat, now, &hat) && seq->hat.loop_from == TRACK_NO_LOOP)
+        running = true;
+
+    if (!running) {
+        button = 0;
+        hat = HAT_CENTER;
+    }
+    ReportData->Button = button;
+    ReportData->HAT = hat;
+    ReportData->VendorSpec = 0;
+    return running;
+}
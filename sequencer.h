@@ -0,0 +1,47 @@
+#ifndef _SEQUENCER_H_
+#define _SEQUENCER_H_
+
+#include "Joystick.h"
+#include "stick.h"
+
+// One step of a button or HAT track: `value` is held for `time` ms.
+// Tracks are read from flash, so tables must be declared const ... PROGMEM.
+typedef struct {
+  uint16_t value; // button mask (JoystickButtons_t) or HAT_* value
+  uint16_t time;
+} TRACK_MAP_t;
+
+// Playback state of one button or HAT track.
+typedef struct {
+  const TRACK_MAP_t *steps;
+  uint8_t count;
+  uint8_t pos;
+  uint8_t loop_from; // restart here after the last step (needs a non-zero step time), TRACK_NO_LOOP to stop
+  uint32_t since;
+} TRACK_t;
+
+#define TRACK_NO_LOOP 0xFF
+
+// Independent tracks merged into one report per poll. All tracks start on the
+// same millisecond, the first time Sequencer_Next() is called.
+typedef struct {
+  TRACK_t button;
+  TRACK_t hat;
+  STICK_ROUTE_t l_stick;
+  STICK_ROUTE_t r_stick;
+  bool started;
+} SEQUENCER_t;
+
+// Clears every track.
+void Sequencer_Init(SEQUENCER_t *seq);
+
+void Sequencer_SetButtons(SEQUENCER_t *seq, const TRACK_MAP_t *steps, uint8_t count, uint8_t loop_from);
+void Sequencer_SetHat(SEQUENCER_t *seq, const TRACK_MAP_t *steps, uint8_t count, uint8_t loop_from);
+void Sequencer_SetLStick(SEQUENCER_t *seq, const STICK_MAP_t *points, uint8_t count);
+void Sequencer_SetRStick(SEQUENCER_t *seq, const STICK_MAP_t *points, uint8_t count);
+
+// Fills the whole report from the tracks. Returns false once every
+// non-looping track has finished; looping tracks are cut off at that point.
+bool Sequencer_Next(SEQUENCER_t *seq, USB_JoystickReport_Input_t *ReportData);
+
+#endif
@@ -0,0 +1,92 @@
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#include "stats.h"
+#include "timer.h"
+
+#ifdef STATS
+
+typedef struct {
+    uint8_t program;
+    uint8_t count;
+    STATS_STATE_t states[STATS_MAX_STATES];
+    uint16_t crc;
+} STATS_BLOCK_t;
+
+static STATS_BLOCK_t EEMEM stored;
+static STATS_BLOCK_t block;
+
+static uint8_t current = 0xFF;
+static uint32_t last_ms;
+static uint32_t flushed_ms;
+
+static uint16_t crc(const STATS_BLOCK_t *b) {
+    const uint8_t *p = (const uint8_t *) b;
+    uint16_t value = 0xFFFF;
+    uint8_t n;
+
+    for (n = 0; n < offsetof(STATS_BLOCK_t, crc); n++)
+        value = _crc16_update(value, p[n]);
+    return value;
+}
+
+static void save(void) {
+    block.crc = crc(&block);
+    eeprom_update_block(&block, &stored, sizeof(block));
+    flushed_ms = millis();
+}
+
+void Stats_Init(PARAMS_PROGRAM_t program) {
+    eeprom_read_block(&block, &stored, sizeof(block));
+    if (block.crc != crc(&block) || block.program != program) {
+        memset(&block, 0, sizeof(block));
+        block.program = program;
+        save();
+    }
+    flushed_ms = millis();
+    stats_report_hook = Stats_Report;
+}
+
+void Stats_Track(uint8_t state) {
+    uint32_t now = millis();
+
+    if (stats_reset_requested) {
+        stats_reset_requested = false;
+        Stats_Reset();
+    }
+    if (current < STATS_MAX_STATES)
+        block.states[current].ms += now - last_ms;
+    last_ms = now;
+    if (state == current)
+        return;
+
+    current = state;
+    if (state < STATS_MAX_STATES) {
+        block.states[state].entries++;
+        if (state >= block.count)
+            block.count = state + 1;
+    }
+    // Only between states, where the EEPROM write (a few ms per changed byte) just stretches a wait.
+    if (Timer_Reached(flushed_ms + STATS_FLUSH_MS))
+        save();
+}
+
+void Stats_Reset(void) {
+    uint8_t program = block.program;
+
+    memset(&block, 0, sizeof(block));
+    block.program = program;
+    current = 0xFF;
+    save();
+}
+
+void Stats_Report(STATS_REPORT_t *report) {
+    report->report_id = STATS_REPORT_ID;
+    report->program = block.program;
+    report->count = block.count;
+    memcpy(report->states, block.states, sizeof(report->states));
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "params.h"
+
+// Throughput counters for farming programs: how often each state was entered
+// and how long the program spent in it, kept across reboots so that two
+// versions of a sequence can be compared on real loops per hour. Counted in
+// RAM and written to EEPROM every STATS_FLUSH_MS, at the next state change.
+//
+// Read and reset them with Feature report STATS_REPORT_ID (host/statsctl).
+// hid.c only reaches them through stats_report_hook, which Stats_Init() sets,
+// so programs that keep no counters don't carry their RAM.
+//
+// Build with STATS (make with-stats); otherwise Stats_Init() and
+// Stats_Track() compile to nothing, leaving the block's ~100 bytes of RAM
+// (and the report's on the control request's stack) to the rest.
+#define STATS_MAX_STATES 12
+#define STATS_FLUSH_MS   600000UL // ten minutes; each flush rewrites the time counters
+#define STATS_REPORT_ID  2
+
+typedef struct __attribute__((packed)) {
+  uint32_t entries;
+  uint32_t ms; // from entering the state to entering the next one
+} STATS_STATE_t;
+
+// Feature report STATS_REPORT_ID as read by the host. A SetReport of just
+// the report ID clears the counters.
+typedef struct __attribute__((packed)) {
+  uint8_t report_id;
+  uint8_t program; // PARAMS_PROGRAM_t
+  uint8_t count;   // states in use
+  STATS_STATE_t states[STATS_MAX_STATES];
+} STATS_REPORT_t;
+
+#ifdef STATS
+
+// Defined in hid.c. The reset is left to Stats_Track(), outside the control request.
+extern void (*volatile stats_report_hook)(STATS_REPORT_t *report);
+extern volatile bool stats_reset_requested;
+
+// Loads the saved counters, starting fresh if they are another program's.
+void Stats_Init(PARAMS_PROGRAM_t program);
+
+// Call with the program's state on every GetNextReport().
+void Stats_Track(uint8_t state);
+
+// Clears the counters, in RAM and EEPROM.
+void Stats_Reset(void);
+
+void Stats_Report(STATS_REPORT_t *report);
+
+#else
+
+static inline void Stats_Init(PARAMS_PROGRAM_t program) { (void) program; }
+static inline void Stats_Track(uint8_t state) { (void) state; }
+
+#endif
+
+#endif
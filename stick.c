@@ -0,0 +1,54 @@
+#include "stick.h"
+#include "timer.h"
+
+uint8_t stickLerp(uint8_t from, uint8_t to, uint16_t elapsed, uint16_t duration, uint8_t curve) {
+    uint32_t t;
+
+    if (elapsed >= duration)
+        return to;
+    // t is the progress in 1/256ths
+    t = ((uint32_t) elapsed << 8) / duration;
+    if (curve == STICK_EASE)
+        t = (t * t * (3 * 256 - 2 * t)) >> 16;
+    return from + (int16_t) (((int32_t) to - from) * (int32_t) t / 256);
+}
+
+void StickRoute_Start(STICK_ROUTE_t *route, const STICK_MAP_t *points, uint8_t count) {
+    route->points = points;
+    route->count = count;
+    route->pos = 0;
+    route->x = STICK_CENTER;
+    route->y = STICK_CENTER;
+    route->started = false;
+}
+
+bool StickRoute_Next(STICK_ROUTE_t *route, uint8_t *x, uint8_t *y) {
+    uint32_t now = millis();
+    uint32_t elapsed;
+    STICK_MAP_t point;
+
+    if (!route->started) {
+        route->since = now;
+        route->started = true;
+    }
+    while (route->pos < route->count) {
+        memcpy_P(&point, &route->points[route->pos], sizeof(point));
+        elapsed = now - route->since;
+        if (elapsed < point.move_time) {
+            *x = stickLerp(route->x, point.x, elapsed, point.move_time, point.curve);
+            *y = stickLerp(route->y, point.y, elapsed, point.move_time, point.curve);
+            return true;
+        }
+        if (elapsed < (uint32_t) point.move_time + point.hold_time) {
+            *x = point.x;
+            *y = point.y;
+            return true;
+        }
+        // Segment finished, the next one starts where this one ended.
+        route->since += (uint32_t) point.move_time + point.hold_time;
+        route->x = point.x;
+        route->y = point.y;
+        route->pos++;
+    }
+    return false;
+}
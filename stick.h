@@ -0,0 +1,40 @@
+#ifndef _STICK_H_
+#define _STICK_H_
+
+#include "Joystick.h"
+
+typedef enum {
+  STICK_LINEAR,
+  STICK_EASE, // smoothstep: slow start and stop, fast in the middle
+} STICK_CURVE_t;
+
+// One waypoint of a stick trajectory. Coordinates are raw 0-255 report values.
+// Routes are read from flash, so tables must be declared const ... PROGMEM.
+typedef struct {
+  uint8_t x;
+  uint8_t y;
+  uint16_t move_time; // ms to travel here from the previous point, 0 jumps
+  uint16_t hold_time; // ms to stay here before heading to the next point
+  uint8_t curve;      // STICK_CURVE_t used for the move
+} STICK_MAP_t;
+
+// Playback state of a PROGMEM STICK_MAP_t table. A route starts from the centre.
+typedef struct {
+  const STICK_MAP_t *points;
+  uint8_t count;
+  uint8_t pos;
+  uint8_t x;
+  uint8_t y;
+  bool started;
+  uint32_t since;
+} STICK_ROUTE_t;
+
+uint8_t stickLerp(uint8_t from, uint8_t to, uint16_t elapsed, uint16_t duration, uint8_t curve);
+
+void StickRoute_Start(STICK_ROUTE_t *route, const STICK_MAP_t *points, uint8_t count);
+
+// Writes the stick position for the current time. Returns false once the last
+// point has been held for its hold_time; x and y are then left untouched.
+bool StickRoute_Next(STICK_ROUTE_t *route, uint8_t *x, uint8_t *y);
+
+#endif
@@ -0,0 +1,132 @@
+#include "stream.h"
+#include "eventlog.h"
+#include "timer.h"
+#include "params.h"
+
+#define STREAM_MASK (STREAM_BUFFER_FRAMES - 1)
+
+static STREAM_FRAME_t frames[STREAM_BUFFER_FRAMES];
+static uint8_t head; // next frame to play
+static uint8_t tail; // next free slot
+static bool playing;
+static bool frame_started;
+static uint32_t frame_since;
+static STREAM_STATUS_t status;
+
+static void count_error(void) {
+    status.errors++;
+    EventLog_Count(EVENTLOG_STREAM_ERROR);
+}
+
+static uint8_t queued(void) {
+    return (uint8_t) (tail - head);
+}
+
+static void enqueue(const uint8_t *payload, uint8_t length) {
+    uint8_t count = length / sizeof(STREAM_FRAME_t);
+
+    if (length % sizeof(STREAM_FRAME_t) || count > STREAM_BUFFER_FRAMES - queued()) {
+        count_error();
+        return;
+    }
+    while (count--) {
+        memcpy(&frames[tail & STREAM_MASK], payload, sizeof(STREAM_FRAME_t));
+        payload += sizeof(STREAM_FRAME_t);
+        tail++;
+    }
+}
+
+void Stream_Command(const uint8_t *packet, uint8_t length) {
+    const uint8_t *payload = packet + STREAM_HEADER_SIZE;
+    uint8_t payload_length;
+    uint16_t errors = status.errors;
+
+    // The header is only read once the packet is known to hold one.
+    if (length < STREAM_HEADER_SIZE || packet[0] != STREAM_MAGIC) {
+        count_error();
+        return;
+    }
+    payload_length = packet[3];
+    if (payload_length > length - STREAM_HEADER_SIZE) {
+        count_error();
+        return;
+    }
+
+    switch (packet[1]) {
+        case STREAM_CMD_ENQUEUE:
+            // Out of order: a repeat of one already taken, or one after a lost packet.
+            if (packet[2] != (uint8_t) (status.seq + 1))
+                return;
+            enqueue(payload, payload_length);
+            break;
+        case STREAM_CMD_START:
+            playing = true;
+            break;
+        case STREAM_CMD_STOP:
+            playing = false;
+            frame_started = false;
+            head = tail;
+            break;
+        case STREAM_CMD_SET:
+            if (payload_length != 3 || !Params_Set(payload[0], payload[1] | (payload[2] << 8)))
+                count_error();
+            break;
+        case STREAM_CMD_STATUS:
+            break;
+        default:
+            count_error();
+            break;
+    }
+    if (status.errors == errors && packet[1] != STREAM_CMD_STATUS)
+        status.seq = packet[2];
+}
+
+bool Stream_NextReport(USB_JoystickReport_Input_t *const ReportData) {
+    const STREAM_FRAME_t *frame;
+    uint32_t now;
+
+    if (!playing)
+        return false;
+
+    now = millis();
+    while (queued()) {
+        frame = &frames[head & STREAM_MASK];
+        if (!frame_started) {
+            frame_since = now;
+            frame_started = true;
+        }
+        if (now - frame_since < frame->duration) {
+            ReportData->Button = frame->button;
+            ReportData->HAT = frame->hat;
+            ReportData->LX = frame->lx;
+            ReportData->LY = frame->ly;
+            ReportData->RX = frame->rx;
+            ReportData->RY = frame->ry;
+            ReportData->VendorSpec = 0;
+            return true;
+        }
+        // Back-to-back frames keep their exact timing.
+        frame_since += frame->duration;
+        head++;
+        status.played++;
+    }
+
+    // Still playing but nothing left: stay neutral until the host catches up.
+    frame_started = false;
+    status.underruns++;
+    EventLog_Count(EVENTLOG_UNDERRUN);
+    memset(ReportData, 0, sizeof(USB_JoystickReport_Input_t));
+    ReportData->HAT = HAT_CENTER;
+    ReportData->LX = STICK_CENTER;
+    ReportData->LY = STICK_CENTER;
+    ReportData->RX = STICK_CENTER;
+    ReportData->RY = STICK_CENTER;
+    return true;
+}
+
+void Stream_GetStatus(STREAM_STATUS_t *out) {
+    status.playing = playing;
+    status.queued = queued();
+    status.free = STREAM_BUFFER_FRAMES - queued();
+    *out = status;
+}
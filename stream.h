@@ -0,0 +1,65 @@
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include "Joystick.h"
+
+// Host-streamed macros (make with-stream). When the board is plugged into a
+// PC, OUT reports starting with STREAM_MAGIC are commands feeding a RAM ring
+// buffer of frames. While playing, the frames replace GetNextReport() as the
+// source of IN reports, so sequences of any length can come from the host
+// without being stored in flash.
+//
+// Packet: STREAM_MAGIC, command, sequence number, payload length, payload.
+// ENQUEUE is only taken with the sequence number following the last accepted
+// one, so a sender may keep several in flight and resend after a loss without
+// frames being played twice or out of order.
+#define STREAM_MAGIC       0xA5
+#define STREAM_HEADER_SIZE 4
+
+typedef enum {
+  STREAM_CMD_ENQUEUE = 0x01, // payload: STREAM_FRAME_t[], all or nothing
+  STREAM_CMD_START   = 0x02,
+  STREAM_CMD_STOP    = 0x03, // also drops the queued frames
+  STREAM_CMD_SET     = 0x04, // payload: PARAM_t, uint16_t value; saved to EEPROM if the program takes it (Params_Valid())
+  STREAM_CMD_STATUS  = 0x05, // query only, leaves the sequence number alone
+} STREAM_COMMAND_t;
+
+// One report to play, held for `duration` ms.
+typedef struct ATTR_PACKED {
+  uint16_t button;
+  uint8_t hat;
+  uint8_t lx;
+  uint8_t ly;
+  uint8_t rx;
+  uint8_t ry;
+  uint16_t duration;
+} STREAM_FRAME_t;
+
+// Answered to a Feature GetReport, so the host can pace itself.
+typedef struct ATTR_PACKED {
+  uint8_t seq;        // sequence number of the last accepted command
+  uint8_t playing;
+  uint8_t queued;     // frames waiting, including the one playing
+  uint8_t free;       // frames that still fit
+  uint16_t played;    // frames finished, wraps
+  uint16_t underruns; // reports sent with an empty buffer while playing
+  uint16_t errors;    // malformed commands and rejected ENQUEUEs
+} STREAM_STATUS_t;
+
+// Must be a power of two. At 1 kHz the UART needs a few round trips of slack.
+#ifndef STREAM_BUFFER_FRAMES
+#ifdef UART_STREAM
+#define STREAM_BUFFER_FRAMES 16
+#else
+#define STREAM_BUFFER_FRAMES 8
+#endif
+#endif
+
+void Stream_Command(const uint8_t *packet, uint8_t length);
+
+// Fills the report from the buffer and returns true while playing.
+bool Stream_NextReport(USB_JoystickReport_Input_t *ReportData);
+
+void Stream_GetStatus(STREAM_STATUS_t *status);
+
+#endif
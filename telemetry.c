@@ -0,0 +1,67 @@
+#include <string.h>
+
+#include "telemetry.h"
+#include "idle.h"
+#include "timer.h"
+
+#ifdef TELEMETRY
+
+TELEMETRY_t telemetry = {.state = TELEMETRY_NO_STATE};
+
+#ifdef __AVR__
+#define STACK_CANARY 0xC5
+
+extern uint8_t _end;
+extern uint8_t __stack;
+
+// Fills the RAM between the static data and the top of the stack with
+// STACK_CANARY before anything runs; free_stack counts what is left of it.
+// Assembly, as r1 is not cleared yet this early.
+void Telemetry_PaintStack(void) __attribute__((naked, used, section(".init1")));
+void Telemetry_PaintStack(void) {
+    __asm volatile("    ldi r30, lo8(_end)\n"
+                   "    ldi r31, hi8(_end)\n"
+                   "    ldi r24, %0\n"
+                   "    ldi r25, hi8(__stack)\n"
+                   "    rjmp 2f\n"
+                   "1:  st Z+, r24\n"
+                   "2:  cpi r30, lo8(__stack)\n"
+                   "    cpc r31, r25\n"
+                   "    brlo 1b\n"
+                   "    breq 1b\n"
+                   :: "i" (STACK_CANARY));
+}
+
+static uint16_t free_stack(void) {
+    const uint8_t *p = &_end;
+    uint16_t count = 0;
+
+    while (p <= &__stack && *p++ == STACK_CANARY)
+        count++;
+    return count;
+}
+#else
+static uint16_t free_stack(void) {
+    return 0xFFFF;
+}
+#endif
+
+void Telemetry_Report(TELEMETRY_REPORT_t *report) {
+    memset(report, 0, sizeof(*report));
+    report->report_id = TELEMETRY_REPORT_ID;
+    strncpy(report->program, PROGRAM_NAME, sizeof(report->program));
+    report->state = telemetry.state;
+    report->map_pos = telemetry.map_pos;
+    report->uptime_ms = millis();
+    report->reports = telemetry.reports;
+    report->in_busy = telemetry.in_busy;
+    report->late_ms = telemetry.late_ms;
+    report->loops = idle_stats.wakeups;
+    report->idle_permille = idle_stats.idle_permille;
+    report->free_stack = free_stack();
+    report->resyncs = telemetry.resyncs;
+    report->resync_requests = telemetry.resync_requests;
+    report->resyncs_per_hour = telemetry.resyncs_per_hour;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "eventlog.h"
+
+// What the board is doing, for a PC to poll while a run is slow: Feature
+// report TELEMETRY_REPORT_ID, answered by hid.c (see host/telemon). Counters
+// are free-running and wrap; the tool works with differences between polls.
+//
+// Build with TELEMETRY (make with-telemetry); otherwise Telemetry_Mark() only
+// feeds the event log and TELEMETRY_ADD() compiles to nothing, so neither the
+// counters nor the report built on the control request's stack take RAM.
+#define TELEMETRY_REPORT_ID 3
+#define TELEMETRY_NO_STATE  0xFF
+
+// The makefile passes TARGET; the host tools name their own.
+#ifndef PROGRAM_NAME
+#define PROGRAM_NAME "?"
+#endif
+
+typedef struct {
+  uint8_t state;         // set by Telemetry_Mark(), TELEMETRY_NO_STATE otherwise
+  uint16_t map_pos;
+  uint32_t reports;      // IN reports handed to the endpoint
+  uint32_t in_busy;      // HID_Task() passes that found the IN bank still full;
+                         // with-usb-isr: frames where it was free but no report was ready
+  uint32_t late_ms;      // how far delay() overran its waits, in total
+  uint16_t resyncs;      // of the program's RESYNC_t, as of its last anchor
+  uint16_t resync_requests;
+  uint16_t resyncs_per_hour;
+} TELEMETRY_t;
+
+#ifdef TELEMETRY
+
+extern TELEMETRY_t telemetry;
+
+// Adds `n` to a counter of `telemetry`.
+#define TELEMETRY_ADD(field, n) (telemetry.field += (n))
+
+#else
+
+#define TELEMETRY_ADD(field, n) ((void) 0)
+
+#endif
+
+// Feature report TELEMETRY_REPORT_ID as read by the host.
+typedef struct __attribute__((packed)) {
+  uint8_t report_id;
+  char program[8];       // NUL-padded, not terminated if 8 long
+  uint8_t state;
+  uint16_t map_pos;
+  uint32_t uptime_ms;
+  uint32_t reports;
+  uint32_t in_busy;
+  uint32_t late_ms;
+  uint32_t loops;        // main loop passes (Idle_Sleep() wakeups)
+  uint16_t idle_permille;
+  uint16_t stream_underruns;
+  uint16_t stream_errors;
+  uint16_t free_stack;   // bytes of RAM never reached by the stack so far, 0xFFFF if unknown
+  uint16_t resyncs;      // resync.h; 0 in programs without an anchor
+  uint16_t resync_requests;
+  uint16_t resyncs_per_hour;
+} TELEMETRY_REPORT_t;
+
+// Call with the program's state and mapPos on every GetNextReport(); also
+// logs the changes to eventlog.h.
+static inline void Telemetry_Mark(uint8_t state, uint16_t map_pos) {
+  EventLog_Mark(state, map_pos);
+#ifdef TELEMETRY
+  telemetry.state = state;
+  telemetry.map_pos = map_pos;
+#endif
+}
+
+#ifdef TELEMETRY
+// Everything but the stream fields, which hid.c fills in when it has a player.
+void Telemetry_Report(TELEMETRY_REPORT_t *report);
+#endif
+
+#endif
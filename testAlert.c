@@ -28,6 +28,8 @@ these buttons for our use.
 #include <util/atomic.h>
 
 #include "Joystick.h"
+#include "idle.h"
+#include "timer.h"
 
 // Main entry point.
 int main(void) {
@@ -41,6 +43,8 @@ int main(void) {
         HID_Task();
         // We also need to run the main USB management task.
         USB_USBTask();
+        // Then doze until the next timer tick or USB interrupt.
+        Idle_Sleep();
     }
 }
 
@@ -61,79 +65,11 @@ void SetupHardware(void) {
     //We'll just flash all pins on both ports since the UNO R3
     DDRB = 0xFF; //uses PORTB. Micro can use either or, but both give us 2 LEDs
     PORTB = 0x0; //The ATmega328P on the UNO will be resetting, so unplug it?
+    Timer_Init();
     // The USB stack should be initialized last.
     USB_Init();
 }
 
-// Fired to indicate that the device is enumerating.
-void EVENT_USB_Device_Connect(void) {
-    // We can indicate that we're enumerating here (via status LEDs, sound, etc.).
-}
-
-// Fired to indicate that the device is no longer connected to a host.
-void EVENT_USB_Device_Disconnect(void) {
-    // We can indicate that our device is not ready (via status LEDs, sound, etc.).
-}
-
-// Fired when the host set the current configuration of the USB device after enumeration.
-void EVENT_USB_Device_ConfigurationChanged(void) {
-    bool ConfigSuccess = true;
-
-    // We setup the HID report endpoints.
-    ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-    ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-
-    // We can read ConfigSuccess to indicate a success or failure at this point.
-}
-
-// Process control requests sent to the device from the USB host.
-void EVENT_USB_Device_ControlRequest(void) {
-    // We can handle two control requests: a GetReport and a SetReport.
-
-    // Not used here, it looks like we don't receive control request from the Switch.
-}
-
-// Process and deliver data from IN and OUT endpoints.
-void HID_Task(void) {
-    // If the device isn't connected and properly configured, we can't do anything here.
-    if (USB_DeviceState != DEVICE_STATE_Configured)
-        return;
-
-    // We'll start with the OUT endpoint.
-    Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
-    // We'll check to see if we received something on the OUT endpoint.
-    if (Endpoint_IsOUTReceived()) {
-        // If we did, and the packet has data, we'll react to it.
-        if (Endpoint_IsReadWriteAllowed()) {
-            // We'll create a place to store our data received from the host.
-            USB_JoystickReport_Output_t JoystickOutputData;
-            // We'll then take in that data, setting it up in our storage.
-            while (Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL) !=
-                   ENDPOINT_RWSTREAM_NoError);
-            // At this point, we can react to this data.
-
-            // However, since we're not doing anything with this data, we abandon it.
-        }
-        // Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
-        Endpoint_ClearOUT();
-    }
-
-    // We'll then move on to the IN endpoint.
-    Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
-    // We first check to see if the host is ready to accept data.
-    if (Endpoint_IsINReady()) {
-        // We'll create an empty report.
-        USB_JoystickReport_Input_t JoystickInputData;
-        // We'll then populate this report with what we want to send to the host.
-        GetNextReport(&JoystickInputData);
-        // Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
-        while (Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL) !=
-               ENDPOINT_RWSTREAM_NoError);
-        // We then send an IN packet on this endpoint.
-        Endpoint_ClearIN();
-    }
-}
-
 USB_JoystickReport_Input_t last_report;
 
 uint8_t ports_val = PORT0;
@@ -145,24 +81,8 @@ typedef enum {
 } State_t;
 State_t state = SYNC_CONTROLLER;
 
-volatile unsigned long timer1_millis;
 long milliseconds_since;
 
-ISR (TIMER1_COMPA_vect) {
-    timer1_millis++;
-}
-
-unsigned long millis() {
-    unsigned long millis_return;
-
-    // Ensure this cannot be disrupted
-    ATOMIC_BLOCK(ATOMIC_FORCEON) {
-        millis_return = timer1_millis;
-    }
-
-    return millis_return;
-}
-
 // Prepare the next report for the host.
 void GetNextReport(USB_JoystickReport_Input_t *const ReportData) {
     unsigned long milliseconds_current = millis();
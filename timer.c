@@ -0,0 +1,63 @@
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "timer.h"
+#include "Joystick.h"
+
+static volatile uint32_t timer1_millis;
+
+ISR (TIMER1_COMPA_vect) {
+    timer1_millis++;
+}
+
+void Timer_Init(void) {
+    TCCR1A = 0;
+    TCCR1B = (1 << WGM12) | (1 << CS10);
+    OCR1A = TIMER_CYCLES_PER_MS - 1;
+    TIMSK1 = (1 << OCIE1A);
+}
+
+uint32_t millis(void) {
+    uint32_t millis_return;
+
+    // Ensure this cannot be disrupted
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        millis_return = timer1_millis;
+    }
+
+    return millis_return;
+}
+
+uint32_t Timer_Cycles(void) {
+    uint32_t ms;
+    uint16_t count;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms = timer1_millis;
+        count = TCNT1;
+        // The counter already wrapped but the tick has not been serviced yet.
+        if ((TIFR1 & (1 << OCF1A)) && count < TIMER_CYCLES_PER_MS / 2)
+            ms++;
+    }
+
+    return ms * TIMER_CYCLES_PER_MS + count;
+}
+
+bool Timer_Reached(uint32_t deadline) {
+    return (int32_t) (millis() - deadline) >= 0;
+}
+
+void Timer_Sleep(void) {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+}
+
+void LongWait_Start(LONG_WAIT_t *wait, uint32_t ms) {
+    wait->deadline = millis() + ms;
+    wait->pending = true;
+}
+
+bool LongWait_Pending(LONG_WAIT_t *wait) {
+    if (wait->pending && Timer_Reached(wait->deadline))
+        wait->pending = false;
+    return wait->pending;
+}
@@ -0,0 +1,39 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Timer1 runs in CTC mode without prescaler, so one compare match is one
+// millisecond (one USB frame) and TCNT1 counts CPU cycles inside it.
+#define TIMER_CYCLES_PER_MS (F_CPU / 1000)
+
+void Timer_Init(void);
+
+// Milliseconds since Timer_Init().
+uint32_t millis(void);
+
+// CPU cycles since Timer_Init(), modulo 2^32 (wraps every ~268 s at 16 MHz).
+// Only differences are meaningful.
+uint32_t Timer_Cycles(void);
+
+// True once millis() has reached `deadline`; safe across the 32-bit wrap.
+bool Timer_Reached(uint32_t deadline);
+
+// Idle the CPU until the next interrupt (the 1 ms tick at the latest).
+void Timer_Sleep(void);
+
+// Non-blocking wait for durations far beyond a uint16_t wait_time (up to
+// ~24 days). The program keeps answering polls with neutral reports while it
+// runs, instead of sitting in _delay_ms with USB unserviced.
+typedef struct {
+  uint32_t deadline;
+  bool pending;
+} LONG_WAIT_t;
+
+void LongWait_Start(LONG_WAIT_t *wait, uint32_t ms);
+
+// True while the wait is running; clears itself once it has expired.
+bool LongWait_Pending(LONG_WAIT_t *wait);
+
+#endif
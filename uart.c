@@ -0,0 +1,101 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "uart.h"
+#include "timer.h"
+
+// Single-producer/single-consumer rings with free-running 8-bit indices: the
+// producer only writes head and the consumer only writes tail, and both are
+// single bytes, so neither side has to disable interrupts.
+#define UART_RX_SIZE 64 // powers of two
+#define UART_TX_SIZE 16
+#define UART_RX_MASK (UART_RX_SIZE - 1)
+#define UART_TX_MASK (UART_TX_SIZE - 1)
+
+static uint8_t rx_data[UART_RX_SIZE];
+static volatile uint8_t rx_head, rx_tail;
+static uint8_t tx_data[UART_TX_SIZE];
+static volatile uint8_t tx_head, tx_tail;
+static volatile uint16_t dropped;
+
+static uint8_t packet[JOYSTICK_EPSIZE];
+static uint8_t packet_pos;
+static uint32_t last_byte;
+
+void Uart_Init(void) {
+    UBRR1 = F_CPU / 8 / UART_BAUD - 1;
+    UCSR1A = _BV(U2X1);
+    UCSR1C = _BV(UCSZ11) | _BV(UCSZ10); // 8N1
+    UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+}
+
+ISR(USART1_RX_vect) {
+    uint8_t flags = UCSR1A;
+    uint8_t data = UDR1;
+
+    if ((flags & (_BV(FE1) | _BV(DOR1))) || (uint8_t) (rx_head - rx_tail) == UART_RX_SIZE) {
+        dropped++;
+        return;
+    }
+    rx_data[rx_head & UART_RX_MASK] = data;
+    rx_head++;
+}
+
+ISR(USART1_UDRE_vect) {
+    if (tx_head == tx_tail) {
+        UCSR1B &= ~_BV(UDRIE1);
+        return;
+    }
+    UDR1 = tx_data[tx_tail & UART_TX_MASK];
+    tx_tail++;
+}
+
+static void reply(void) {
+    UART_REPLY_t out = {.magic = UART_REPLY_MAGIC};
+    const uint8_t *p = (const uint8_t *) &out;
+    uint8_t n;
+
+    // The sender retries unanswered packets, so a reply that does not fit is skipped.
+    if (UART_TX_SIZE - (uint8_t) (tx_head - tx_tail) < sizeof(out))
+        return;
+
+    Stream_GetStatus(&out.status);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        out.dropped = dropped;
+    }
+    for (n = 0; n < sizeof(out); n++) {
+        tx_data[tx_head & UART_TX_MASK] = p[n];
+        tx_head++;
+    }
+    UCSR1B |= _BV(UDRIE1);
+}
+
+void Uart_Task(void) {
+    uint8_t data;
+
+    if (packet_pos && millis() - last_byte > UART_PACKET_TIMEOUT_MS)
+        packet_pos = 0;
+
+    while (rx_head != rx_tail) {
+        data = rx_data[rx_tail & UART_RX_MASK];
+        rx_tail++;
+        last_byte = millis();
+
+        // Resynchronise on the magic byte after noise or a lost byte.
+        if (packet_pos == 0 && data != STREAM_MAGIC)
+            continue;
+        packet[packet_pos++] = data;
+        if (packet_pos < STREAM_HEADER_SIZE)
+            continue;
+        if (packet[3] > sizeof(packet) - STREAM_HEADER_SIZE) {
+            packet_pos = 0;
+            continue;
+        }
+        if (packet_pos == STREAM_HEADER_SIZE + packet[3]) {
+            Stream_Command(packet, packet_pos);
+            reply();
+            packet_pos = 0;
+        }
+    }
+}
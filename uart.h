@@ -0,0 +1,37 @@
+#ifndef _UART_H_
+#define _UART_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stream.h"
+
+// Stream commands over USART1 (make with-uart). On the UNO R3 the 16u2's
+// USART is wired to the 328P, so it (or a PC on the same lines) can feed the
+// stream player while the 16u2 keeps talking USB to the Switch.
+//
+// Bytes are the same packets as on the OUT endpoint. Every complete packet is
+// answered with a UART_REPLY_t, which doubles as flow control: the sender
+// keeps at most one packet in flight and only queues as many frames as
+// `status.free` allows.
+#ifndef UART_BAUD
+#define UART_BAUD 250000 // 25 bytes per ms, exact at 16 MHz with U2X
+#endif
+
+#define UART_REPLY_MAGIC 0x5A
+
+// A partial packet is dropped after this long without a byte.
+#define UART_PACKET_TIMEOUT_MS 5
+
+typedef struct ATTR_PACKED {
+  uint8_t magic;
+  STREAM_STATUS_t status;
+  uint16_t dropped; // bytes lost to a full receive ring, framing or overrun errors
+} UART_REPLY_t;
+
+void Uart_Init(void);
+
+// Decodes received bytes into stream commands; call from the main loop.
+void Uart_Task(void);
+
+#endif